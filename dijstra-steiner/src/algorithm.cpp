@@ -1,285 +1,503 @@
 #include <iostream>
 #include "algorithm.h"
-#include <queue>
-#include <bitset>
 #include <vector>
 #include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "counters.h"
+#include "label_index.h"
+#include "priority_queue.h"
+#include "hanan_grid.h"
+#include "fst.h"
+#include "heuristic.h"
+#include "lookup_table.h"
+#include "lower_bound.h"
+#include "reduction.h"
+#include "result_cache.h"
+#include "thread_pool.h"
 
 namespace Algorithm {
-  
-  //Equality comparison for tuples v,I
-  bool operator==(const Length_vI& lhs, const Length_vI& rhs) {
-    return &lhs == &rhs; // Compare memory addresses
+
+  //bytes the dense label index may take, a quarter of the memory limit but at most 64 MB
+  std::size_t denseIndexLimit(std::size_t memoryLimit)
+  {
+    std::size_t limit = std::size_t(64) << 20;
+    return memoryLimit == 0 ? limit : std::min(limit, memoryLimit / 4);
   }
-  
-  //returns minimum and maximum x and y coords.
-  std::vector<Coordinate> calculateExtremes(std::vector<Terminal> const& vertices)
-  { 
-    Coordinate minX = vertices[0].x, maxX = vertices[0].x;
-    Coordinate minY = vertices[0].y, maxY = vertices[0].y;
-    for (const auto& vertex : vertices) {
-      if (vertex.x < minX) minX = vertex.x;
-      if (vertex.x > maxX) maxX = vertex.x;
-      if (vertex.y < minY) minY = vertex.y;
-      if (vertex.y > maxY) maxY = vertex.y;
+
+  //state of one run of the algorithm.
+  //Mask is an unsigned integer type with at least as many bits as there are terminals,
+  //CounterHooks is NoCounters or Counters (see counters.h).
+  //with a LabelState the search continues from its labels and hands them back at the end
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  class Search
+  {
+  public:
+    Search(std::vector<Terminal> const& terminals, Options const& options,
+           HananGrid const& grid, std::vector<std::uint8_t> const& removed, LabelState<Mask>* state = nullptr)
+      : _terminals(terminals),
+        _options(options),
+        _grid(grid),                                        //edges between adjacent grid lines have the length of the coordinate gap
+        _removed(removed),
+        _root(_grid.vertexOf(terminals[0])),
+        _allTerminals(allTerminalsWithoutFirst<Mask>(terminals.size())),   //0000000011111111111110
+        _lowerBound(terminals),                             //lb(v,T\I), the bounds cache what they need per subset
+        _labels(state ? std::move(state->labels) : LabelIndex<Mask>(_grid.numVertices(), terminals.size(), denseIndexLimit(options.memoryLimit))),
+        _smt(state ? std::move(state->smt) : std::vector<std::vector<LabelId>>(_grid.numVertices())),
+        _upperBound(Heuristic::steiner_insertion(terminals)),  //labels which cannot beat this tree are pruned
+        _state(state)
+    {}
+
+    Result run();
+
+  private:
+    //a relaxation found by a worker thread, it is applied after all labels of the batch were expanded
+    struct Relaxation
+    {
+      std::uint32_t vertex;
+      Mask terminalSet;
+      Coordinate cost;
+    };
+
+    void relax(std::uint32_t w, Mask terminalSet, Coordinate cost);
+    void tightenUpperBound(std::uint32_t w, Coordinate cost);
+    template <class Relax>
+    void expand(LabelId current, Relax&& relax);
+    void expandBatch();
+    void fillQueue();
+    void requeue();
+    void enforceMemoryLimit();
+    bool timeLimitReached() const;
+    Result finish();
+
+    std::vector<Terminal> const& _terminals;
+    Options const& _options;
+    std::chrono::steady_clock::time_point const _start = std::chrono::steady_clock::now();
+
+    HananGrid const& _grid;
+    std::vector<std::uint8_t> const& _removed;              //vertices dropped by the reductions, never relaxed
+    std::uint32_t const _root;
+    Mask const _allTerminals;
+    LowerBound const _lowerBound;
+
+    //define l(v,I) data structure, every (v,I) that was reached is in the index, the queue holds the tentative ones
+    LabelIndex<Mask> _labels;
+    Queue _queue;
+
+    //define set P of sets l(v,I) = smt({v} u I), grouped by v for step 7.
+    //these lists are dropped if the memory limit is hit, step 7 then only uses the index
+    std::vector<std::vector<LabelId>> _smt;
+    bool _lowMemory = false;
+
+    //length of the best Steiner tree found so far
+    Coordinate _upperBound;
+    LabelState<Mask>* const _state;
+
+    //labels moved to P together, with more than one thread all labels of the minimum key
+    std::vector<LabelId> _batch;
+    std::unique_ptr<ThreadPool> _pool;
+    std::vector<std::vector<Relaxation>> _pending;   //per thread
+
+    [[no_unique_address]] CounterHooks _counters;
+    std::size_t _nextCheck = 0;   //settled labels at which the memory and time limits are checked next
+    Result _result;
+  };
+
+  //lowers l(w,I) to cost if (w,I) is not in P yet and updates its key in the queue.
+  //labels with l(w,I)+lb(w,T\I) >= upper bound cannot lead to a shorter tree and are not queued,
+  //their cost is still kept for a search that continues from the labels with other terminals
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  void Search<Mask, Queue, LowerBound, CounterHooks>::relax(std::uint32_t w, Mask terminalSet, Coordinate cost)
+  {
+    LabelId id = _labels.get(w, terminalSet);
+    Label<Mask>& label = _labels[id];
+    if (label.permanent() || label.cost <= cost) return;
+    if (label.lb < 0) {
+      label.lb = _counters.lowerBound([&] { return _lowerBound(_grid.position(w), terminalSet); });  //first time (w,I) is reached
     }
-    return {minX, maxX, minY, maxY};
+    if (terminalSet == _allTerminals) tightenUpperBound(w, cost);
+
+    label.cost = cost;
+    if (cost + label.lb >= _upperBound) return;
+    if constexpr (HasPruningBound<LowerBound, Mask>) {
+      if (cost + _lowerBound.pruning(_grid.position(w), terminalSet) >= _upperBound) return;
+    }
+    _queue.push(id, cost + label.lb);
+    _counters.pushed(_queue.size());
   }
-  
-  //returns BB of a list of vertices
-  Coordinate boundingBox(std::vector<Terminal> const& vertices) 
+
+  //(w,T\{r}) plus a shortest path from w to the root is a Steiner tree
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  void Search<Mask, Queue, LowerBound, CounterHooks>::tightenUpperBound(std::uint32_t w, Coordinate cost)
   {
-    std::vector<Coordinate> coords = calculateExtremes(vertices);
-    return coords[1] - coords[0] + coords[3] - coords[2];
+    Terminal const wPosition = _grid.position(w);
+    Terminal const& root = _terminals[0];
+    _upperBound = std::min(_upperBound, cost + std::abs(wPosition.x - root.x) + std::abs(wPosition.y - root.y));
   }
-  
-  //returns BB of a vertex and a bitset (bitset should be I, not T\I)
-  Coordinate bitsetBoundingBox(Terminal const& v, std::bitset<MAX_NUM_TERMINALS> const& terminalSet, std::vector<Terminal> const& allTerminals)
+
+  //continues from the labels of a search for another terminal set, which only holds labels (v,I) with I in the
+  //current terminals. labels in P are exact whatever the other terminals are, and every tentative label holds its
+  //best relaxation from P, so queueing the tentative ones with the new lower bounds restores a valid state
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  void Search<Mask, Queue, LowerBound, CounterHooks>::requeue()
   {
-    //transform terminalSet to vertex set
-    std::vector<Terminal> terminalList;
-    for(std::size_t i=0; i< allTerminals.size(); i++)
-    {
-      if(!terminalSet.test(i)) terminalList.push_back(allTerminals[i]);
+    for (LabelId id = 0; id < _labels.size(); id++) {
+      Label<Mask>& label = _labels[id];
+      if (label.permanent()) {
+        if (label.terminalSet == _allTerminals) tightenUpperBound(label.vertex(), label.cost);
+        continue;
+      }
+      Coordinate const cost = label.cost;
+      if (cost == std::numeric_limits<Coordinate>::max()) continue;
+      label.cost = std::numeric_limits<Coordinate>::max();
+      label.lb = -1;
+      relax(label.vertex(), label.terminalSet, cost);
     }
-    terminalList.push_back(v);
-    
-    //find bounding box of vertex set
-    return boundingBox(terminalList);
-    
+    fillQueue();
   }
-  
-  //initialize heap with l(s,{s})=0
-  void fillHeap(LengthHeap& l, std::vector<Terminal> const& terminals, int n) 
+
+  //initialize queue with l(s,{s})=0
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  void Search<Mask, Queue, LowerBound, CounterHooks>::fillQueue()
   {
-    for (int i=1; i<n; i++)
+    for (std::size_t i=1; i<_terminals.size(); i++)
     {
-      std::bitset<MAX_NUM_TERMINALS> s;
-      s.set(i);
-      Coordinate lb = bitsetBoundingBox(terminals[i], s, terminals);
-      l.push_back(Length_vI {0, lb, terminals[i] , s});
+      relax(_grid.vertexOf(_terminals[i]), Mask(1) << i, 0);
+    }
+  }
+
+  //if the search uses more than the memory limit, drops the lists of P per vertex first (lowMemory mode),
+  //throws if that was not enough
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  void Search<Mask, Queue, LowerBound, CounterHooks>::enforceMemoryLimit()
+  {
+    std::size_t used = _labels.memoryUsage() + _queue.memoryUsage() + _lowerBound.memoryUsage();
+    used += _smt.capacity() * sizeof(std::vector<LabelId>) + _batch.capacity() * sizeof(LabelId);
+    for (auto const& smt_v : _smt) used += smt_v.capacity() * sizeof(LabelId);
+    for (auto const& pending : _pending) used += pending.capacity() * sizeof(Relaxation);
+    if (used <= _options.memoryLimit) return;
+
+    if (!_lowMemory) {
+      _lowMemory = true;
+      for (auto& smt_v : _smt) std::vector<LabelId>().swap(smt_v);
+      return;
     }
-    
-    //heapify the list
-    std::make_heap(l.begin(), l.end(), lengthComparator());
-    
-    return;
+    throw std::runtime_error("Memory limit of " + std::to_string(_options.memoryLimit >> 20) + " MB exceeded after "
+      + std::to_string(_result.labelsSettled) + " settled labels.");
   }
-  
-  //implements step3 of the dijkstra-steiner algorithm (also step 4 at the end)
-  Length_vI step3(LengthHeap& l, std::vector<Length_vI>& p)
-  { 
-    //pop the root of the heap
-    std::pop_heap(l.begin(), l.end(), lengthComparator());
-    Length_vI current_vI = l.back();
-    l.pop_back();
-    
-    //add it to P
-    p.emplace_back(current_vI);
-    return current_vI;
+
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  bool Search<Mask, Queue, LowerBound, CounterHooks>::timeLimitReached() const
+  {
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - _start;
+    return elapsed.count() > _options.timeLimit;
   }
-  
-  Coordinate dijkstra_steiner(std::vector<Terminal> const& terminals)
-  { 
-    //Find out minX,maxX,minY,maxY of Hanan grid
-    std::vector<Coordinate> dimensions = calculateExtremes(terminals); 
-    
-    const int numberOfTerminals = terminals.size();
-    std::bitset<MAX_NUM_TERMINALS> allTerminalsWithoutFirst;              //example of bit operations below
-    allTerminalsWithoutFirst.set();                                       //1111111111111111111111
-    allTerminalsWithoutFirst >>= MAX_NUM_TERMINALS - numberOfTerminals;   //0000000011111111111111
-    allTerminalsWithoutFirst.reset(0);                                    //0000000011111111111110
-    
-    
-    //define l(v,I) data structure
-    LengthHeap length_heap;
-    fillHeap(length_heap, terminals, numberOfTerminals);
-    
-    //define set P of sets l(v,I) = smt({v} u I)
-    std::vector<Length_vI> smt;
-    
-    while(true) {
-      //find minimum l(v,I)+lb(v,T\I)
-      Length_vI current_vI = step3(length_heap, smt);
-      
-      
-      //step 5, return if we found v,T\v
-      if ((std::get<2>(current_vI) == terminals[0]) &&
-      (std::get<3>(current_vI) == allTerminalsWithoutFirst))
+
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  Result Search<Mask, Queue, LowerBound, CounterHooks>::finish()
+  {
+    _counters.report(_result, _labels.size());
+    if (_state) {
+      _state->labels = std::move(_labels);
+      _state->smt = std::move(_smt);
+    }
+    return _result;
+  }
+
+  //step6 and step7 for a label in P, every candidate (w,I,l) is passed to relax.
+  //only reads the index, so several labels can be expanded at the same time
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  template <class Relax>
+  void Search<Mask, Queue, LowerBound, CounterHooks>::expand(LabelId current, Relax&& relax)
+  {
+    std::uint32_t v = _labels[current].vertex();               //(must not actually be a terminal, just a vertex)
+    Coordinate cost = _labels[current].cost;
+    Mask terminalSet = _labels[current].terminalSet;
+    std::vector<LabelId> const& smt_v = _smt[v];
+
+    //step6, relax (w,I) for all neighbours w of v, edge lengths are the gaps between the grid lines
+    std::size_t column = _grid.column(v);
+    std::size_t row = _grid.row(v);
+    std::size_t const numColumns = _grid.numColumns();
+    if(column != 0 && !_removed[v - 1]) {
+      _counters.relaxed();
+      relax(v - 1, terminalSet, cost + _grid.xGap(column - 1));
+    }
+    if(column + 1 != numColumns && !_removed[v + 1]) {
+      _counters.relaxed();
+      relax(v + 1, terminalSet, cost + _grid.xGap(column));
+    }
+    if(row != 0 && !_removed[v - numColumns]) {
+      _counters.relaxed();
+      relax(v - numColumns, terminalSet, cost + _grid.yGap(row - 1));
+    }
+    if(row + 1 != _grid.numRows() && !_removed[v + numColumns]) {
+      _counters.relaxed();
+      relax(v + numColumns, terminalSet, cost + _grid.yGap(row));
+    }
+
+    //step7, relax (v,I u J) for all (v,J) in P with disjoint J. Either enumerate all J in the complement
+    //of I and look them up in the index, or go through P at v, whichever has fewer candidates
+    //(relax may not add to smt_v, so the reference stays valid)
+    Mask complement = _allTerminals & Mask(~terminalSet);
+    if (_lowMemory || (std::popcount(complement) < 63 && (std::uint64_t(1) << std::popcount(complement)) <= smt_v.size()))
+    {
+      for(Mask otherSet = complement; otherSet != 0; otherSet = (otherSet - 1) & complement)
       {
-        return std::get<0>(current_vI);
-      }
-      
-      //prepare step 6 and 7
-      Terminal v = std::get<2>(current_vI);               //(must not actually be a terminal, just a vertex)
-      Coordinate cost = std::get<0>(current_vI);
-      std::bitset<MAX_NUM_TERMINALS> terminalSet = std::get<3>(current_vI);  
-      
-
-      //std::cout << "step 3 vertex: (" << v.x << "," << v.y << ") length: " << cost << std::endl << terminalSet << std::endl;
-      
-      //step6, first check which edges can be added
-      bool addLeft  = v.x != dimensions[0];
-      bool addRight = v.x != dimensions[1];
-      bool addDown  = v.y != dimensions[2];
-      bool addUp    = v.y != dimensions[3];
-      
-      //step7, check which (v,J) are viable
-      std::vector<Length_vI> list_vJ;
-      for(Length_vI p : smt)
-      { 	
-        Terminal other_v = std::get<2>(p);
-        if((v.x == other_v.x)&&( v.y == other_v.y) && (!(std::get<3>(p) & terminalSet).any())){ //if bitsets are disjoint, no bits are true for bitwise AND
-          list_vJ.push_back(p);
-        }
+        LabelId other = _labels.find(v, otherSet);
+        if(other == LabelIndex<Mask>::NO_LABEL || !_labels[other].permanent()) continue;
+        _counters.merged();
+        relax(v, Mask(terminalSet | otherSet), cost + _labels[other].cost);
       }
-      std::vector<bool> used_vJ(list_vJ.size(),false); //needed to add l(v,I)'s which are infinite, so not in the heap
-      
-      //iterate through heap to reduce l(v,I) for step 6 and 7 (these do not have to be in order, since they cannot affect each other)
-      //heap property may be violated
-      for(Length_vI& vertexTerminals : length_heap) 
+    }
+    else
+    {
+      for(LabelId other : smt_v)
       {
-        Terminal& w = std::get<2>(vertexTerminals);
-        std::bitset<MAX_NUM_TERMINALS>& terminalsIJ = std::get<3>(vertexTerminals);
-        Coordinate oldCost = std::get<0>(vertexTerminals);
-        
-        if((v.x == w.x) && (v.y == w.y)) {                      //if v = w we can try to apply step 7
-          for(std::size_t i = 0; i < list_vJ.size(); i++)
-          {
-            Length_vI vJ = list_vJ[i];
-            if((std::get<3>(vJ) | terminalSet) == terminalsIJ) {  //try to match terminal sets to I u J
-              Coordinate costJ = std::get<0>(vJ);
-              if(cost + costJ < oldCost) std::get<0>(vertexTerminals) = cost + costJ;  //overwrite old cost if sum is lower
-              used_vJ[i] = true;
-              break;
-            }
-          } continue;                                           //if v=w it cannot be connected by an edge
-        }
-        
-        if(addLeft && (w.x +1 == v.x) && (w.y == v.y) && (terminalSet == terminalsIJ))            //try to find vertices on adjacent edges
-        {
-          if(cost + 1 < oldCost) std::get<0>(vertexTerminals) = cost+1;
-          addLeft = false;
-          continue;
-        }
-        
-        if(addRight && (w.x -1 == v.x) && (w.y == v.y)&& (terminalSet == terminalsIJ))
-        {
-          if(cost + 1 < oldCost) std::get<0>(vertexTerminals) = cost+1;
-          addRight = false;
-          continue;
-        }
-        
-        if(addDown && (w.y +1 == v.y) && (w.x == v.x)&& (terminalSet == terminalsIJ))
-        {
-          
-          if(cost + 1 < oldCost) std::get<0>(vertexTerminals) = cost+1;
-          addDown = false;
-          continue;
-        }
-        
-        if(addUp && (w.y -1 == v.y) && (w.x == v.x)&& (terminalSet == terminalsIJ))
-        {
-          if(cost + 1 < oldCost) std::get<0>(vertexTerminals) = cost+1;
-          addUp = false;
-          continue;
-        }
+        Mask otherSet = _labels[other].terminalSet;
+        if((otherSet & terminalSet) != 0) continue;  //J has to be disjoint from I
+        _counters.merged();
+        relax(v, Mask(terminalSet | otherSet), cost + _labels[other].cost);
       }
-      
-      //Since infinite elements are not in the heap, we do not know if they are in P or not defined yet.
-      //Here we get rid of tuples in P 
-      for(Length_vI& vertexTerminals : smt) 
-      {
-        Terminal& w = std::get<2>(vertexTerminals);
-        std::bitset<MAX_NUM_TERMINALS>& terminalsIJ = std::get<3>(vertexTerminals);
-        
-        if((v.x == w.x) && (v.y == w.y)) {                      //if v = w we can try to apply step 7
-          for(std::size_t i = 0; i < list_vJ.size(); i++)
-          {
-            Length_vI vJ = list_vJ[i];
-            if((std::get<3>(vJ) | terminalSet) == terminalsIJ) {  //try to match terminal sets to I u J
-              used_vJ[i] = true;
-              break;
-            }
-          } continue;
-        }
-        
-        if(addLeft && (w.x +1 == v.x) && (w.y == v.y)&& (terminalSet == terminalsIJ))            //try to find vertices on adjacent edges
-        {
-          addLeft = false;
-          continue;
-        }
-        
-        if(addRight && (w.x -1 == v.x) && (w.y == v.y)&& (terminalSet == terminalsIJ))
-        {
-          addRight = false;
-          continue;
+    }
+  }
+
+  //expands the labels of the batch on all threads. the workers only collect the candidates which may
+  //improve a label, the index and the queue are updated afterwards by this thread
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  void Search<Mask, Queue, LowerBound, CounterHooks>::expandBatch()
+  {
+    if (!_pool || _batch.size() <= ThreadPool::SERIAL_SIZE) {
+      for (LabelId current : _batch) {
+        expand(current, [this](std::uint32_t w, Mask terminalSet, Coordinate cost) { relax(w, terminalSet, cost); });
+      }
+      return;
+    }
+
+    _pool->parallel_for(_batch.size(), [this](std::size_t i, std::size_t thread) {
+      std::vector<Relaxation>& pending = _pending[thread];
+      expand(_batch[i], [this, &pending](std::uint32_t w, Mask terminalSet, Coordinate cost) {
+        LabelId id = _labels.find(w, terminalSet);
+        if (id != LabelIndex<Mask>::NO_LABEL) {
+          Label<Mask> const& label = _labels[id];
+          if (label.permanent() || label.cost <= cost) return;
         }
-        
-        if(addDown && (w.y +1 == v.y) && (w.x == v.x)&& (terminalSet == terminalsIJ))
-        {
-          addDown = false;
-          continue;
+        pending.push_back(Relaxation{w, terminalSet, cost});
+      });
+    });
+    for (auto& pending : _pending) {
+      for (Relaxation const& r : pending) relax(r.vertex, r.terminalSet, r.cost);
+      pending.clear();
+    }
+  }
+
+  template <class Mask, class Queue, class LowerBound, class CounterHooks>
+  Result Search<Mask, Queue, LowerBound, CounterHooks>::run()
+  {
+    if (_options.threads > 1) {
+      _pool = std::make_unique<ThreadPool>(_options.threads);
+      _pending.resize(_pool->size());
+    }
+    if (_state) requeue();
+    else fillQueue();
+
+    while(true) {
+      //every label left in the queue is at least as long as the upper bound, so that tree is optimal
+      if (_queue.empty() || _queue.minKey() >= _upperBound) {
+        _result.length = _upperBound;
+        _result.lowerBound = _upperBound;
+        return finish();
+      }
+
+      if (_result.labelsSettled >= _nextCheck) {
+        _nextCheck = _result.labelsSettled + 1024;
+        if (_options.memoryLimit != 0) enforceMemoryLimit();
+
+        //give up on optimality, the minimum key is a lower bound for every tree that is still to be found
+        if (_options.timeLimit > 0 && timeLimitReached()) {
+          _result.length = _upperBound;
+          _result.lowerBound = std::min(_queue.minKey(), _upperBound);
+          _result.optimal = false;
+          return finish();
         }
-        
-        if(addUp && (w.y -1 == v.y) && (w.x == v.x)&& (terminalSet == terminalsIJ))
+      }
+
+      //step 3 and 4, move (v,I) with minimum l(v,I)+lb(v,T\I) to P. With several threads all labels with
+      //the minimum key are moved at once: lb is consistent, so expanding one of them only yields keys at
+      //least as large and cannot lower another one
+      _batch.clear();
+      Coordinate const key = _queue.minKey();
+      do {
+        LabelId current = _queue.pop();
+        _labels[current].makePermanent();
+        _result.labelsSettled++;
+        _counters.settled(std::popcount(_labels[current].terminalSet), _result.labelsSettled);
+
+        std::uint32_t v = _labels[current].vertex();
+        Coordinate cost = _labels[current].cost;
+        Mask terminalSet = _labels[current].terminalSet;
+
+        //std::cout << "step 3 vertex: " << v << " length: " << cost << std::endl << terminalSet << std::endl;
+
+        if (!_lowMemory) _smt[v].push_back(current);
+        _batch.push_back(current);
+
+        //step 5, return if we found v,T\v. labels that are handed on are expanded first,
+        //so that no label in P is missing from the tentative costs
+        if ((v == _root) && (terminalSet == _allTerminals))
         {
-          addUp = false;
-          continue;
+          _result.length = cost;
+          _result.lowerBound = cost;
+          if (_state) expandBatch();
+          return finish();
         }
-      }
+      } while (_pool && _queue.hasKey(key));
 
-      //restore heap property
-      std::make_heap(length_heap.begin(), length_heap.end(), lengthComparator());
-      
-      if(addLeft) //if vertex left of v was not found in heap, it's cost was infinite
-      {
-        std::bitset<MAX_NUM_TERMINALS> s = terminalSet;         //same I
-        Terminal w = {v.x-1,v.y};                               //adjust coordinates
-        Coordinate lb = bitsetBoundingBox(w, s, terminals);                  //compute lb
-        length_heap.push_back(Length_vI {cost + 1, lb, w, s});  //add to heap
-        std::push_heap(length_heap.begin(), length_heap.end(), lengthComparator());
-      }
-      if(addRight)
-      {
-        std::bitset<MAX_NUM_TERMINALS> s = terminalSet;
-        Terminal w = {v.x+1,v.y};
-        Coordinate lb = bitsetBoundingBox(w, s, terminals);
-        length_heap.push_back(Length_vI {cost + 1, lb, w, s});
-        std::push_heap(length_heap.begin(), length_heap.end(), lengthComparator());
-      }
-      if(addDown)
-      {
-        std::bitset<MAX_NUM_TERMINALS> s = terminalSet;
-        Terminal w = {v.x,v.y-1};
-        Coordinate lb = bitsetBoundingBox(w, s, terminals);
-        length_heap.push_back(Length_vI {cost + 1, lb, w, s});
-        std::push_heap(length_heap.begin(), length_heap.end(), lengthComparator());
+      expandBatch();
+    }
+  }
+
+  //the counting instantiation only exists for --stats, the normal one has no trace of it
+  template <class Mask, class Queue, class LowerBound>
+  Result search(std::vector<Terminal> const& terminals, Options const& options,
+                HananGrid const& grid, std::vector<std::uint8_t> const& removed, LabelState<Mask>* state)
+  {
+    if (options.stats) return Search<Mask, Queue, LowerBound, Counters>(terminals, options, grid, removed, state).run();
+    return Search<Mask, Queue, LowerBound, NoCounters>(terminals, options, grid, removed, state).run();
+  }
+
+  template <class Mask, class Queue>
+  Result search(std::vector<Terminal> const& terminals, Options const& options,
+                HananGrid const& grid, std::vector<std::uint8_t> const& removed, LabelState<Mask>* state)
+  {
+    switch (options.lowerBound) {
+    case LowerBoundType::Mst:
+      return search<Mask, Queue, MstBound<Mask>>(terminals, options, grid, removed, state);
+    case LowerBoundType::BoundingBox:
+    default:
+      return search<Mask, Queue, BoundingBoxBound<Mask>>(terminals, options, grid, removed, state);
+    }
+  }
+
+  template <class Mask>
+  Result search(std::vector<Terminal> const& terminals, Options const& options,
+                HananGrid const& grid, std::vector<std::uint8_t> const& removed, LabelState<Mask>* state = nullptr)
+  {
+    switch (options.queue) {
+    case QueueType::RadixQueue:
+      return search<Mask, RadixQueue>(terminals, options, grid, removed, state);
+    case QueueType::DaryHeap:
+    default:
+      return search<Mask, DaryHeap<4>>(terminals, options, grid, removed, state);
+    }
+  }
+
+  //solves the parts of an instance that was split at a cut terminal one after another,
+  //the tree is the union of their trees. the time limit is shared by all parts
+  Result combine(std::vector<std::vector<Terminal>> const& parts, Options const& options)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    Result result;
+    for (auto const& part : parts) {
+      Options partOptions = options;
+      if (options.timeLimit > 0) {
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+        partOptions.timeLimit = std::max(options.timeLimit - elapsed.count(), 1e-9);
       }
-      if(addUp)
-      {
-        std::bitset<MAX_NUM_TERMINALS> s = terminalSet;
-        Terminal w = {v.x,v.y+1};
-        Coordinate lb = bitsetBoundingBox(w, s, terminals);
-        length_heap.push_back(Length_vI {cost + 1, lb, w, s});
-        std::push_heap(length_heap.begin(), length_heap.end(), lengthComparator());
+      Result const partResult = dijkstra_steiner(part, partOptions);
+      result.length += partResult.length;
+      result.lowerBound += partResult.lowerBound;
+      result.optimal = result.optimal && partResult.optimal;
+      result.labelsSettled += partResult.labelsSettled;
+      result.searchedVertices += partResult.searchedVertices;
+      result.parts += partResult.parts;
+      add(result.stats, partResult.stats);
+    }
+    return result;
+  }
+
+  Result dijkstra_steiner(std::vector<Terminal> const& terminals, Options const& options)
+  {
+    if (terminals.size() < 2) return Result{};
+
+    HananGrid const grid(terminals);
+    std::vector<std::uint8_t> removed(grid.numVertices(), 0);
+    if (options.reduce) {
+      removed = Reduction::removed_vertices(grid, terminals);
+      auto const parts = Reduction::split_at_cut_terminal(grid, terminals, removed);
+      if (!parts.empty()) {
+        Result result = combine(parts, options);
+        result.gridVertices = grid.numVertices();
+        return result;
       }
-      
-      for(std::size_t i = 0; i < list_vJ.size(); i++)
-      {
-        if(used_vJ[i]) continue;
-        std::bitset<MAX_NUM_TERMINALS> s = terminalSet | std::get<3>(list_vJ[i]);
-        Coordinate l_vIJ = cost + std::get<0>(list_vJ[i]);
-        Coordinate lb = bitsetBoundingBox(v, s, terminals);
-        length_heap.push_back(Length_vI {l_vIJ, lb, v, s});
-        std::push_heap(length_heap.begin(), length_heap.end(), lengthComparator());
+    }
+
+    Result result;
+    //the smallest mask type with a bit for every terminal
+    if (terminals.size() <= 16) result = search<std::uint16_t>(terminals, options, grid, removed);
+    else if (terminals.size() <= 32) result = search<std::uint32_t>(terminals, options, grid, removed);
+    else result = search<std::uint64_t>(terminals, options, grid, removed);
+
+    result.gridVertices = grid.numVertices();
+    result.searchedVertices = grid.numVertices() - std::count(removed.begin(), removed.end(), 1);
+    result.parts = 1;
+    return result;
+  }
+
+  Result dijkstra_steiner(std::vector<Terminal> const& terminals, Options const& options,
+                          HananGrid const& grid, LabelState<std::uint64_t>& state)
+  {
+    if (terminals.size() < 2) return Result{};
+    std::vector<std::uint8_t> const removed(grid.numVertices(), 0);
+    Result result = search<std::uint64_t>(terminals, options, grid, removed, &state);
+    result.gridVertices = grid.numVertices();
+    result.searchedVertices = grid.numVertices();
+    result.parts = 1;
+    return result;
+  }
+
+  Result solveUncached(std::vector<Terminal> const& terminals, Options const& options)
+  {
+    bool const useFst = options.engine == Engine::Fst
+      || (options.engine == Engine::Auto && terminals.size() > AUTO_DIJKSTRA_STEINER_TERMINALS);
+    if (useFst) return Fst::fst_steiner(terminals, options);
+
+    if (terminals.size() > MAX_NUM_TERMINALS) {
+      throw std::runtime_error("Dijkstra-Steiner cannot handle instances with more than " + std::to_string(MAX_NUM_TERMINALS) + " terminals.");
+    }
+    return dijkstra_steiner(terminals, options);
+  }
+
+  Result solve(std::vector<Terminal> const& terminals, Options const& options)
+  {
+    if (options.table != nullptr) {
+      if (auto const length = options.table->length(terminals)) {
+        Result result;
+        result.length = *length;
+        result.lowerBound = *length;
+        result.fromTable = true;
+        return result;
       }
-      
-      
     }
-    
-    
-    return 0;
+    if (options.cache == nullptr) return solveUncached(terminals, options);
+
+    ResultCache::Key const key = ResultCache::key(terminals);
+    if (auto const length = options.cache->find(key)) {
+      Result result;
+      result.length = *length;
+      result.lowerBound = *length;
+      result.fromCache = true;
+      return result;
+    }
+    Result result = solveUncached(terminals, options);
+    if (result.optimal) options.cache->insert(key, result.length);   //a time limited result is not the optimum
+    return result;
   }
-  
+
 }
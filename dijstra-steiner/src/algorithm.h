@@ -1,34 +1,98 @@
 #ifndef ALGORITHM_H
 #define ALGORITHM_H
 
+#include <cstddef>
 #include <vector>
 #include "common.h"
-#include <queue>
-#include <bitset>
-#include <vector>
+
+class HananGrid;
+class LookupTable;
+class ResultCache;
+template <class Mask> struct LabelState;
 
 namespace Algorithm {
-Coordinate dijkstra_steiner(std::vector<Terminal> const& terminals);
-}
 
-//for each (v,I) save (l(v,I), lb(v,T\I), v , I)
-using Length_vI = std::tuple<Coordinate, Coordinate, Terminal, std::bitset<MAX_NUM_TERMINALS>>;
-
-// To compare lengths of tuples in our heap
-class lengthComparator 
-{ 
-  public: 
-    bool operator() (Length_vI const& vs1, 
-      Length_vI const& vs2) 
-    { 
-      //compare l(v,I)+lb(v,T\I)
-      Coordinate l1 = std::get<0>(vs1)+std::get<1>(vs1);
-      Coordinate l2 = std::get<0>(vs2)+std::get<1>(vs2);
-
-      return (l1 > l2); 
-    } 
-}; 
-
-using LengthHeap = std::vector<Length_vI>;
+//priority queue used for the tentative labels
+enum class QueueType
+{
+  DaryHeap,     //indexed 4-ary heap with decrease-key
+  RadixQueue    //monotone radix heap
+};
+
+//feasible lower bound lb(v,T\I) for the future cost
+enum class LowerBoundType
+{
+  BoundingBox,  //half perimeter of the bounding box of {v} u T\I
+  Mst           //BoundingBox, and pruning with 2/3 of a minimum spanning tree on {v} u T\I
+};
+
+//exact algorithm, Auto uses Dijkstra-Steiner up to AUTO_DIJKSTRA_STEINER_TERMINALS terminals and
+//full Steiner tree concatenation (Fst::fst_steiner) for larger instances
+enum class Engine
+{
+  Auto,
+  DijkstraSteiner,
+  Fst
+};
+auto constexpr AUTO_DIJKSTRA_STEINER_TERMINALS = 8;
+
+struct Options
+{
+  Engine engine = Engine::Auto;
+  QueueType queue = QueueType::DaryHeap;
+  LowerBoundType lowerBound = LowerBoundType::BoundingBox;
+  std::size_t memoryLimit = 0;      //bytes for labels, index, queue, lists of P and lower bound tables, 0 for no limit
+  double timeLimit = 0;             //seconds after which the best tree found so far is returned, 0 for no limit
+  bool reduce = true;               //remove grid vertices and split at cut terminals before the search
+  std::size_t threads = 1;          //threads expanding the labels of Dijkstra-Steiner
+  bool stats = false;               //collect the counters of Result::stats, the search is slower with them
+  ResultCache* cache = nullptr;     //lengths of instances solved before, looked up and filled by solve
+  LookupTable const* table = nullptr;   //exact lengths of small nets, tried by solve before the cache and the search
+};
+
+//counters of a Dijkstra-Steiner search, summed over the parts (the peaks are the maximum over the parts)
+struct Statistics
+{
+  std::size_t labelsPushed = 0;         //pushes into the queue, decrease-key included
+  std::size_t labelsPopped = 0;         //labels moved from the queue to P
+  std::size_t labelsRelaxed = 0;        //candidates (w,I) from a neighbour in step 6
+  std::size_t labelsMerged = 0;         //candidates (v,I u J) from two labels in P in step 7
+  std::size_t labelsStored = 0;         //labels in the index, every (v,I) that was reached
+  std::size_t peakQueueSize = 0;
+  std::size_t peakPermanentLabels = 0;  //labels in P, they are never removed, so this is the count at the end
+  double lowerBoundSeconds = 0;         //time spent computing lb(v,T\I)
+  std::vector<std::size_t> settledBySize;   //labels moved to P by the number of terminals |I|
+};
+
+struct Result
+{
+  Coordinate length = 0;            //length of a minimum Steiner tree, or of the best tree found if not optimal
+  Coordinate lowerBound = 0;        //lower bound for the length of a minimum Steiner tree
+  bool optimal = true;              //false if the time limit was reached
+  std::size_t labelsSettled = 0;    //number of labels moved to P
+  std::size_t gridVertices = 0;     //vertices of the Hanan grid of all terminals
+  std::size_t searchedVertices = 0; //vertices left after the reductions, summed over all parts
+  std::size_t parts = 0;            //number of instances the terminals were split into at cut terminals
+  std::size_t fullSteinerTrees = 0; //full Steiner trees generated by fst_steiner
+  std::size_t branchNodes = 0;      //nodes of the branch and bound of fst_steiner
+  Statistics stats;                 //only filled if Options::stats is set
+  bool fromCache = false;           //the length was found in Options::cache, nothing was searched
+  bool fromTable = false;           //the length was found in Options::table, nothing was searched
+};
+
+//bytes the dense label index may take under the memory limit (0 for no limit)
+std::size_t denseIndexLimit(std::size_t memoryLimit);
+
+Result dijkstra_steiner(std::vector<Terminal> const& terminals, Options const& options = {});
+
+//continues from the labels in state, which a search for another terminal set on the same grid left there,
+//and leaves its own labels in it. runs without reductions, see IncrementalSteiner
+Result dijkstra_steiner(std::vector<Terminal> const& terminals, Options const& options,
+                        HananGrid const& grid, LabelState<std::uint64_t>& state);
+
+//length of a minimum Steiner tree with the engine chosen by the options, from the lookup table of the options
+//for small nets or from the cache if an instance of the same canonical form was solved before
+Result solve(std::vector<Terminal> const& terminals, Options const& options = {});
+}
 
 #endif /*ALGORITHM_H */
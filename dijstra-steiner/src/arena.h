@@ -0,0 +1,37 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//bump allocator for records that are referenced by their index. records are stored in fixed size
+//blocks that never move, so growing does not copy (and temporarily double) everything allocated so far
+template <class T, int BLOCK_BITS = 16>
+class Arena
+{
+public:
+  std::uint32_t push_back(T const& record)
+  {
+    if ((_size & BLOCK_MASK) == 0) _blocks.emplace_back(new T[BLOCK_SIZE]);
+    _blocks.back()[_size & BLOCK_MASK] = record;
+    return _size++;
+  }
+
+  T& operator[](std::uint32_t index) { return _blocks[index >> BLOCK_BITS][index & BLOCK_MASK]; }
+  T const& operator[](std::uint32_t index) const { return _blocks[index >> BLOCK_BITS][index & BLOCK_MASK]; }
+
+  std::size_t size() const { return _size; }
+
+  //bytes allocated for the records
+  std::size_t memoryUsage() const { return _blocks.size() * BLOCK_SIZE * sizeof(T); }
+
+private:
+  static constexpr std::size_t BLOCK_SIZE = std::size_t(1) << BLOCK_BITS;
+  static constexpr std::size_t BLOCK_MASK = BLOCK_SIZE - 1;
+
+  std::vector<std::unique_ptr<T[]>> _blocks;
+  std::size_t _size = 0;
+};
+
+#endif /*ARENA_H */
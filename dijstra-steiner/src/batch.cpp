@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include "batch.h"
+#include "parser.h"
+#include "thread_pool.h"
+
+namespace Batch {
+
+namespace {
+  //field quoted as in RFC 4180 if it contains a separator, a quote or a line break
+  std::string csvField(std::string const& field)
+  {
+    if (field.find_first_of(",\"\n\r") == std::string::npos) return field;
+    std::string quoted = "\"";
+    for (char c : field) {
+      if (c == '"') quoted += '"';
+      quoted += c;
+    }
+    return quoted + '"';
+  }
+
+}
+
+std::vector<std::string> instance_files(std::vector<std::string> const& paths)
+{
+  std::vector<std::string> files;
+  for (std::string const& path : paths) {
+    if (!std::filesystem::is_directory(path)) {
+      files.push_back(path);
+      continue;
+    }
+    std::vector<std::string> inDirectory;
+    for (auto const& entry : std::filesystem::directory_iterator(path)) {
+      std::string const extension = entry.path().extension().string();
+      if (entry.is_regular_file() && (extension == ".txt" || extension == ".bin")) inDirectory.push_back(entry.path().string());
+    }
+    std::sort(inDirectory.begin(), inDirectory.end());
+    files.insert(files.end(), inDirectory.begin(), inDirectory.end());
+  }
+  return files;
+}
+
+std::size_t run(std::vector<std::string> const& files, Algorithm::Options const& options, std::size_t jobs, std::ostream& out)
+{
+  //all instances are read first, the number of terminals is the estimate for the running time
+  std::vector<std::vector<Terminal>> instances(files.size());
+  std::vector<std::string> lines(files.size());
+  std::vector<std::uint8_t> failed(files.size(), 0);
+  for (std::size_t i = 0; i < files.size(); i++) {
+    try {
+      instances[i] = Parser::read_instance(files[i]);
+    } catch (std::exception const& e) {
+      lines[i] = csvField(files[i]) + ",,,,,,," + csvField(e.what());
+      failed[i] = 1;
+    }
+  }
+
+  std::vector<std::size_t> order(files.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&instances](std::size_t a, std::size_t b) {
+    return instances[a].size() > instances[b].size();
+  });
+
+  //lines are written as soon as all lines before them are done
+  std::mutex mutex;
+  std::vector<std::uint8_t> done(files.size(), 0);
+  std::size_t nextLine = 0;
+  out << "file,terminals,length,lower_bound,optimal,labels_settled,time,error" << std::endl;
+
+  run_work_stealing(jobs, files.size(), [&](std::size_t k) {
+    std::size_t const i = order[k];
+    std::string line = lines[i];
+    if (line.empty()) {
+      try {
+        auto const start = std::chrono::steady_clock::now();
+        Algorithm::Result const result = Algorithm::solve(instances[i], options);
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+        line = csvField(files[i]) + "," + std::to_string(instances[i].size()) + "," + std::to_string(result.length) + ","
+          + std::to_string(result.lowerBound) + "," + (result.optimal ? "1" : "0") + ","
+          + std::to_string(result.labelsSettled) + "," + std::to_string(elapsed.count()) + ",";
+      } catch (std::exception const& e) {
+        line = csvField(files[i]) + ",,,,,,," + csvField(e.what());
+        failed[i] = 1;
+      }
+    }
+    std::vector<Terminal>().swap(instances[i]);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    lines[i] = std::move(line);
+    done[i] = 1;
+    for (; nextLine < files.size() && done[nextLine]; nextLine++) out << lines[nextLine] << '\n';
+    out.flush();
+  });
+  return std::count(failed.begin(), failed.end(), 1);
+}
+
+}
@@ -0,0 +1,25 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "algorithm.h"
+
+//Solves many instance files in one process, several at the same time.
+namespace Batch {
+
+//the given paths with every directory replaced by the .txt and .bin (binary) instances in it, sorted by name
+std::vector<std::string> instance_files(std::vector<std::string> const& paths);
+
+//solves the files on jobs threads, the instances with the most terminals first, and writes a header and the line
+//  file,terminals,length,lower_bound,optimal,labels_settled,time,
+//per file to out, in the order of the files. an instance which cannot be read or solved gets the line
+//  file,,,,,,,error message
+//and does not stop the others. returns the number of such instances
+std::size_t run(std::vector<std::string> const& files, Algorithm::Options const& options, std::size_t jobs, std::ostream& out);
+
+}
+
+#endif /*BATCH_H */
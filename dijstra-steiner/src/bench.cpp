@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <span>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "hanan_grid.cpp"
+#include "heuristic.cpp"
+#include "reduction.cpp"
+#include "mapped_file.cpp"
+#include "result_cache.cpp"
+#include "lookup_table.cpp"
+#include "thread_pool.cpp"
+#include "linear_program.cpp"
+#include "fst.cpp"
+#include "algorithm.cpp"
+#include "generator.cpp"
+#include "algorithm.h"
+#include "common.h"
+#include "generator.h"
+#include "lookup_table.h"
+
+//Benchmark of the exact solver on generated instances: for every configuration (kind, number of terminals,
+//coordinate range) the instances with seeds 1..k are solved, checked against the stored optima and the
+//median and 95th percentile of the time and of the settled labels are written as one CSV line.
+
+namespace {
+  std::vector<std::size_t> const ALL_SIZES = {5, 8, 11, 14, 17, 20};
+  std::vector<std::size_t> const DEFAULT_SIZES = {5, 8, 11, 14};   //larger ones take minutes per instance
+  std::vector<Coordinate> const RANGES = {100, 10000, 1000000};
+  std::vector<Generator::Kind> const KINDS = {Generator::Kind::Random, Generator::Kind::Clustered};
+  std::uint64_t constexpr DEFAULT_INSTANCES = 10;
+
+  using OptimumKey = std::tuple<std::string, std::size_t, Coordinate, std::uint64_t>;   //kind, terminals, range, seed
+
+  void print_usage(std::span<const char*> args)
+  {
+    std::cout << "Benchmark of the exact solver on generated instances.\n"
+              << "Usage: " << args[0] << " [options]                 run the benchmark, one CSV line per configuration\n"
+              << "       " << args[0] << " --write-optima [options]  compute the optima with the full Steiner tree engine\n"
+              << "       " << args[0] << " --generate <kind> <n> <range> <seed>   print an instance (kind random or clustered)\n"
+              << "       " << args[0] << " --compare <old.csv> <new.csv>           compare the output of two runs\n"
+              << "       " << args[0] << " --write-table <file> <degree> [--threads <n>]   generate the lookup table for 2..degree terminals\n"
+              << "       " << args[0] << " --check-table <file> [--instances <k>]  compare the lookup table with the search\n"
+              << "Options:\n"
+              << "  --sizes <list>    Numbers of terminals, comma separated (default 5,8,11,14, at most 20)\n"
+              << "  --instances <k>   Instances per configuration, seeds 1..k (default 10)\n"
+              << "  --optima <file>   Known optimal lengths (default bench/optima.csv)\n"
+              << "  --engine, --queue, --lb, --threads, --time-limit, --no-reduce, --table   as for main" << std::endl;
+  }
+
+  std::vector<std::size_t> parseList(std::string const& list)
+  {
+    std::vector<std::size_t> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) values.push_back(std::stoull(item));
+    return values;
+  }
+
+  //nearest rank percentile of a sorted sample
+  template <class T>
+  T percentile(std::vector<T> const& sorted, double p)
+  {
+    std::size_t rank = std::size_t(std::ceil(p * sorted.size()));
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+  }
+
+  std::map<OptimumKey, Coordinate> readOptima(std::string const& file)
+  {
+    std::map<OptimumKey, Coordinate> optima;
+    std::ifstream input(file);
+    if (input.fail()) throw std::runtime_error("Cannot open file: " + file);
+    std::string line;
+    std::getline(input, line);    //header
+    while (std::getline(input, line)) {
+      if (line.empty()) continue;
+      std::stringstream stream(line);
+      std::string kind, terminals, range, seed, length;
+      std::getline(stream, kind, ',');
+      std::getline(stream, terminals, ',');
+      std::getline(stream, range, ',');
+      std::getline(stream, seed, ',');
+      std::getline(stream, length, ',');
+      optima[OptimumKey{kind, std::stoull(terminals), std::stoi(range), std::stoull(seed)}] = std::stoi(length);
+    }
+    return optima;
+  }
+
+  //rows of a benchmark output in their order
+  std::vector<std::vector<std::string>> readRun(std::string const& file)
+  {
+    std::vector<std::vector<std::string>> rows;
+    std::ifstream input(file);
+    if (input.fail()) throw std::runtime_error("Cannot open file: " + file);
+    std::string line;
+    std::getline(input, line);
+    while (std::getline(input, line)) {
+      std::vector<std::string> fields;
+      std::stringstream stream(line);
+      std::string field;
+      while (std::getline(stream, field, ',')) fields.push_back(field);
+      if (fields.size() < 10) continue;
+      rows.push_back(fields);
+    }
+    return rows;
+  }
+
+  void writeOptima(std::uint64_t instances, std::ostream& out)
+  {
+    Algorithm::Options options;
+    options.engine = Algorithm::Engine::Fst;
+    out << "kind,terminals,range,seed,length" << std::endl;
+    for (Generator::Kind kind : KINDS) {
+      for (std::size_t n : ALL_SIZES) {
+        for (Coordinate range : RANGES) {
+          for (std::uint64_t seed = 1; seed <= instances; seed++) {
+            Coordinate const length = Algorithm::solve(Generator::generate(kind, n, range, seed), options).length;
+            out << Generator::name(kind) << "," << n << "," << range << "," << seed << "," << length << std::endl;
+          }
+        }
+      }
+    }
+  }
+
+  //returns the number of instances whose length differs from the stored optimum
+  std::size_t run(std::vector<std::size_t> const& sizes, std::uint64_t instances, Algorithm::Options const& options,
+                  std::map<OptimumKey, Coordinate> const& optima, std::ostream& out)
+  {
+    std::size_t wrongTotal = 0;
+    out << "kind,terminals,range,instances,solved,wrong,median_time,p95_time,median_labels,p95_labels" << std::endl;
+    for (Generator::Kind kind : KINDS) {
+      for (std::size_t n : sizes) {
+        for (Coordinate range : RANGES) {
+          std::vector<double> times;
+          std::vector<std::size_t> labels;
+          std::size_t solved = 0;
+          std::size_t wrong = 0;
+          for (std::uint64_t seed = 1; seed <= instances; seed++) {
+            auto const terminals = Generator::generate(kind, n, range, seed);
+            auto const start = std::chrono::steady_clock::now();
+            Algorithm::Result const result = Algorithm::solve(terminals, options);
+            std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+            times.push_back(elapsed.count());
+            labels.push_back(result.labelsSettled);
+            if (!result.optimal) continue;
+            solved++;
+
+            auto const optimum = optima.find(OptimumKey{Generator::name(kind), n, range, seed});
+            if (optimum == optima.end()) {
+              std::cerr << "no stored optimum for " << Generator::name(kind) << " " << n << " " << range << " " << seed << std::endl;
+            }
+            else if (optimum->second != result.length) {
+              std::cerr << "wrong length for " << Generator::name(kind) << " " << n << " " << range << " " << seed
+                        << ": " << result.length << " instead of " << optimum->second << std::endl;
+              wrong++;
+            }
+          }
+          std::sort(times.begin(), times.end());
+          std::sort(labels.begin(), labels.end());
+          out << Generator::name(kind) << "," << n << "," << range << "," << instances << "," << solved << "," << wrong << ","
+              << percentile(times, 0.5) << "," << percentile(times, 0.95) << ","
+              << percentile(labels, 0.5) << "," << percentile(labels, 0.95) << std::endl;
+          wrongTotal += wrong;
+        }
+      }
+    }
+    return wrongTotal;
+  }
+
+  //every net of 2..degree terminals generated for the benchmark, solved by the table and by Dijkstra-Steiner.
+  //one CSV line per degree, the times are per net. returns the number of nets with different lengths
+  std::size_t checkTable(LookupTable const& table, std::uint64_t instances, std::ostream& out)
+  {
+    Algorithm::Options options;
+    options.engine = Algorithm::Engine::DijkstraSteiner;
+    std::size_t wrongTotal = 0;
+    out << "terminals,instances,wrong,table_time,search_time" << std::endl;
+    for (std::size_t n = 2; n <= table.maxDegree(); n++) {
+      std::size_t count = 0;
+      std::size_t wrong = 0;
+      std::chrono::duration<double> tableTime{0};
+      std::chrono::duration<double> searchTime{0};
+      for (Generator::Kind kind : KINDS) {
+        for (Coordinate range : RANGES) {
+          for (std::uint64_t seed = 1; seed <= instances; seed++) {
+            auto const terminals = Generator::generate(kind, n, range, seed);
+            auto const start = std::chrono::steady_clock::now();
+            std::optional<Coordinate> const length = table.length(terminals);
+            auto const looked = std::chrono::steady_clock::now();
+            Coordinate const optimum = Algorithm::dijkstra_steiner(terminals, options).length;
+            tableTime += looked - start;
+            searchTime += std::chrono::steady_clock::now() - looked;
+            count++;
+            if (length != optimum) {
+              std::cerr << "wrong length for " << Generator::name(kind) << " " << n << " " << range << " " << seed
+                        << ": " << (length ? std::to_string(*length) : "none") << " instead of " << optimum << std::endl;
+              wrong++;
+            }
+          }
+        }
+      }
+      out << n << "," << count << "," << wrong << "," << tableTime.count() / count << "," << searchTime.count() / count << std::endl;
+      wrongTotal += wrong;
+    }
+    return wrongTotal;
+  }
+
+  //median times and labels of two runs side by side, the ratio is new / old
+  void compare(std::string const& oldFile, std::string const& newFile, std::ostream& out)
+  {
+    //configurations are identified by kind, terminals and range
+    auto const key = [](std::vector<std::string> const& fields) { return fields[0] + "," + fields[1] + "," + fields[2]; };
+    std::map<std::string, std::vector<std::string>> oldRun;
+    for (auto const& fields : readRun(oldFile)) oldRun[key(fields)] = fields;
+
+    out << "kind,terminals,range,old_median_time,new_median_time,time_ratio,old_median_labels,new_median_labels" << std::endl;
+    for (auto const& newFields : readRun(newFile)) {
+      auto const old = oldRun.find(key(newFields));
+      if (old == oldRun.end()) continue;
+      double const oldTime = std::stod(old->second[6]);
+      double const newTime = std::stod(newFields[6]);
+      out << key(newFields) << "," << oldTime << "," << newTime << "," << (oldTime > 0 ? newTime / oldTime : 1.0) << ","
+          << old->second[8] << "," << newFields[8] << std::endl;
+    }
+  }
+}
+
+int main(int argc, char const* argv[])
+{
+  auto const args = std::span(argv, argc);
+  Algorithm::Options options;
+  options.engine = Algorithm::Engine::DijkstraSteiner;
+  std::vector<std::size_t> sizes = DEFAULT_SIZES;
+  std::uint64_t instances = DEFAULT_INSTANCES;
+  std::string optimaFile = "bench/optima.csv";
+  bool writeOptimaMode = false;
+  std::string writeTableFile;
+  std::size_t tableDegree = 0;
+  std::string checkTableFile;
+  std::unique_ptr<LookupTable> table;
+
+  try {
+    for (std::size_t i = 1; i < args.size(); i++) {
+      std::string const arg = args[i];
+      if (arg == "--generate" && i + 4 < args.size()) {
+        auto const terminals = Generator::generate(Generator::kind_from_name(args[i + 1]), std::stoull(args[i + 2]),
+                                                   std::stoi(args[i + 3]), std::stoull(args[i + 4]));
+        std::cout << terminals.size() << "\n";
+        for (Terminal const& t : terminals) std::cout << t.x << " " << t.y << "\n";
+        return EXIT_SUCCESS;
+      } else if (arg == "--compare" && i + 2 < args.size()) {
+        compare(args[i + 1], args[i + 2], std::cout);
+        return EXIT_SUCCESS;
+      } else if (arg == "--write-table" && i + 2 < args.size()) {
+        writeTableFile = args[i + 1];
+        tableDegree = std::stoull(args[i + 2]);
+        i += 2;
+      } else if (arg == "--check-table" && i + 1 < args.size()) {
+        checkTableFile = args[++i];
+      } else if (arg == "--table" && i + 1 < args.size()) {
+        table = std::make_unique<LookupTable>(args[++i]);
+        options.table = table.get();
+      } else if (arg == "--write-optima") {
+        writeOptimaMode = true;
+      } else if (arg == "--sizes" && i + 1 < args.size()) {
+        sizes = parseList(args[++i]);
+      } else if (arg == "--instances" && i + 1 < args.size()) {
+        instances = std::stoull(args[++i]);
+      } else if (arg == "--optima" && i + 1 < args.size()) {
+        optimaFile = args[++i];
+      } else if (arg == "--engine" && i + 1 < args.size()) {
+        std::string const engine = args[++i];
+        options.engine = engine == "fst" ? Algorithm::Engine::Fst
+          : (engine == "auto" ? Algorithm::Engine::Auto : Algorithm::Engine::DijkstraSteiner);
+      } else if (arg == "--queue" && i + 1 < args.size()) {
+        options.queue = std::string(args[++i]) == "radix" ? Algorithm::QueueType::RadixQueue : Algorithm::QueueType::DaryHeap;
+      } else if (arg == "--lb" && i + 1 < args.size()) {
+        std::string const bound = args[++i];
+        options.lowerBound = bound == "mst" ? Algorithm::LowerBoundType::Mst : Algorithm::LowerBoundType::BoundingBox;
+      } else if (arg == "--threads" && i + 1 < args.size()) {
+        std::string const count = args[++i];
+        if (count.starts_with('-')) throw std::runtime_error("Invalid thread count: " + count);
+        std::size_t const threads = std::stoull(count);
+        options.threads = std::clamp<std::size_t>(threads, 1, std::max(1u, std::thread::hardware_concurrency()));
+      } else if (arg == "--time-limit" && i + 1 < args.size()) {
+        options.timeLimit = std::stod(args[++i]);
+      } else if (arg == "--no-reduce") {
+        options.reduce = false;
+      } else {
+        print_usage(args);
+        return 1;
+      }
+    }
+
+    if (!writeTableFile.empty()) {
+      LookupTable::write(writeTableFile, tableDegree, options.threads);
+      return EXIT_SUCCESS;
+    }
+    if (!checkTableFile.empty()) {
+      return checkTable(LookupTable(checkTableFile), instances, std::cout) == 0 ? EXIT_SUCCESS : 1;
+    }
+    if (writeOptimaMode) {
+      std::ofstream out(optimaFile);
+      if (out.fail()) throw std::runtime_error("Cannot open file: " + optimaFile);
+      writeOptima(instances, out);
+      return EXIT_SUCCESS;
+    }
+    if (instances == 0) throw std::runtime_error("At least one instance per configuration is needed.");
+    for (std::size_t n : sizes) {
+      if (n < 2 || n > MAX_NUM_TERMINALS) throw std::runtime_error("Invalid number of terminals: " + std::to_string(n));
+    }
+    auto const optima = readOptima(optimaFile);
+    return run(sizes, instances, options, optima, std::cout) == 0 ? EXIT_SUCCESS : 1;
+
+  } catch (std::exception const& e) {
+    std::cout << "Exception occurred: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -1,7 +1,8 @@
 #ifndef COMMON_H
 #define COMMON_H
 
-auto constexpr MAX_NUM_TERMINALS = 20;
+//terminal sets are bit masks of at most 64 bits
+auto constexpr MAX_NUM_TERMINALS = 64;
 using Coordinate = int;
 
 struct Terminal
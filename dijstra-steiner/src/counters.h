@@ -0,0 +1,86 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include "algorithm.h"
+#include "common.h"
+
+namespace Algorithm {
+
+//Hooks through which the search reports what it does, the search is instantiated with one of
+//  NoCounters   every hook is empty and the class has no state, so the search compiles as without hooks
+//  Counters     fills Statistics, chosen by Options::stats
+//relaxed() and merged() may be called by the worker threads of a batch at the same time.
+
+struct NoCounters
+{
+  void pushed(std::size_t /*queueSize*/) {}
+  void settled(int /*terminalsInSet*/, std::size_t /*permanentLabels*/) {}
+  void relaxed() {}
+  void merged() {}
+  template <class ComputeBound>
+  Coordinate lowerBound(ComputeBound const& compute) { return compute(); }
+  void report(Result& /*result*/, std::size_t /*labelsStored*/) const {}
+};
+
+class Counters
+{
+public:
+  void pushed(std::size_t queueSize)
+  {
+    _stats.labelsPushed++;
+    _stats.peakQueueSize = std::max(_stats.peakQueueSize, queueSize);
+  }
+
+  void settled(int terminalsInSet, std::size_t permanentLabels)
+  {
+    _stats.labelsPopped++;
+    _stats.peakPermanentLabels = std::max(_stats.peakPermanentLabels, permanentLabels);
+    if (_stats.settledBySize.size() <= std::size_t(terminalsInSet)) _stats.settledBySize.resize(terminalsInSet + 1, 0);
+    _stats.settledBySize[terminalsInSet]++;
+  }
+
+  void relaxed() { std::atomic_ref<std::size_t>(_stats.labelsRelaxed).fetch_add(1, std::memory_order_relaxed); }
+  void merged() { std::atomic_ref<std::size_t>(_stats.labelsMerged).fetch_add(1, std::memory_order_relaxed); }
+
+  template <class ComputeBound>
+  Coordinate lowerBound(ComputeBound const& compute)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    Coordinate const bound = compute();
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    _stats.lowerBoundSeconds += elapsed.count();
+    return bound;
+  }
+
+  void report(Result& result, std::size_t labelsStored) const
+  {
+    result.stats = _stats;
+    result.stats.labelsStored = labelsStored;
+  }
+
+private:
+  Statistics _stats;
+};
+
+//adds the counters of a part of the instance to those of the whole
+inline void add(Statistics& total, Statistics const& part)
+{
+  total.labelsPushed += part.labelsPushed;
+  total.labelsPopped += part.labelsPopped;
+  total.labelsRelaxed += part.labelsRelaxed;
+  total.labelsMerged += part.labelsMerged;
+  total.labelsStored += part.labelsStored;
+  total.peakQueueSize = std::max(total.peakQueueSize, part.peakQueueSize);
+  total.peakPermanentLabels = std::max(total.peakPermanentLabels, part.peakPermanentLabels);
+  total.lowerBoundSeconds += part.lowerBoundSeconds;
+  if (total.settledBySize.size() < part.settledBySize.size()) total.settledBySize.resize(part.settledBySize.size(), 0);
+  for (std::size_t k = 0; k < part.settledBySize.size(); k++) total.settledBySize[k] += part.settledBySize[k];
+}
+
+}
+
+#endif /*COUNTERS_H */
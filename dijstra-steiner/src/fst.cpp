@@ -0,0 +1,680 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include "fst.h"
+#include "linear_program.h"
+
+namespace Fst {
+
+namespace {
+  Coordinate distance(Terminal const& a, Terminal const& b)
+  {
+    return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+  }
+
+  //disjoint set union with path halving
+  class UnionFind
+  {
+  public:
+    explicit UnionFind(std::size_t n) : _parent(n) { std::iota(_parent.begin(), _parent.end(), 0); }
+
+    std::uint32_t find(std::uint32_t a)
+    {
+      while (_parent[a] != a) a = _parent[a] = _parent[_parent[a]];
+      return a;
+    }
+
+    bool unite(std::uint32_t a, std::uint32_t b)
+    {
+      a = find(a);
+      b = find(b);
+      if (a == b) return false;
+      _parent[b] = a;
+      return true;
+    }
+
+  private:
+    std::vector<std::uint32_t> _parent;
+  };
+
+  //bottleneck Steiner distances: B(a,b) is the longest edge on the path from a to b in a minimum spanning tree
+  //of the terminals. if removing a segment of a minimum Steiner tree separates a from b, the segment is at most
+  //B(a,b) long, otherwise the tree could be reconnected by an edge of that path
+  class BottleneckDistances
+  {
+  public:
+    explicit BottleneckDistances(std::vector<Terminal> const& terminals)
+      : _n(terminals.size()), _matrix(_n * _n, 0)
+    {
+      //Prim on the complete graph, O(n^2)
+      std::vector<Coordinate> dist(_n, std::numeric_limits<Coordinate>::max());
+      std::vector<std::uint32_t> parent(_n, 0);
+      std::vector<char> inTree(_n, 0);
+      std::vector<std::vector<std::pair<std::uint32_t, Coordinate>>> adjacent(_n);
+      dist[0] = 0;
+      for (std::size_t step = 0; step < _n; step++) {
+        std::uint32_t next = 0;
+        Coordinate best = std::numeric_limits<Coordinate>::max();
+        for (std::uint32_t v = 0; v < _n; v++) {
+          if (!inTree[v] && dist[v] < best) {
+            best = dist[v];
+            next = v;
+          }
+        }
+        inTree[next] = 1;
+        if (step != 0) {
+          _mstEdges.emplace_back(parent[next], next);
+          adjacent[parent[next]].emplace_back(next, best);
+          adjacent[next].emplace_back(parent[next], best);
+          _longestEdge = std::max(_longestEdge, best);
+        }
+        for (std::uint32_t v = 0; v < _n; v++) {
+          Coordinate d = distance(terminals[next], terminals[v]);
+          if (!inTree[v] && d < dist[v]) {
+            dist[v] = d;
+            parent[v] = next;
+          }
+        }
+      }
+
+      //longest edge on the tree path from every a, one depth first search each
+      std::vector<std::uint32_t> stack;
+      for (std::uint32_t a = 0; a < _n; a++) {
+        Coordinate* row = &_matrix[a * _n];
+        std::vector<char> visited(_n, 0);
+        visited[a] = 1;
+        stack.push_back(a);
+        while (!stack.empty()) {
+          std::uint32_t v = stack.back();
+          stack.pop_back();
+          for (auto const& [w, length] : adjacent[v]) {
+            if (visited[w]) continue;
+            visited[w] = 1;
+            row[w] = std::max(row[v], length);
+            stack.push_back(w);
+          }
+        }
+      }
+    }
+
+    Coordinate operator()(std::uint32_t a, std::uint32_t b) const { return _matrix[a * _n + b]; }
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> const& mstEdges() const { return _mstEdges; }
+    Coordinate longestEdge() const { return _longestEdge; }
+
+    //length of a minimum spanning tree of the subset w.r.t. the bottleneck distances
+    Coordinate mstLength(std::vector<std::uint32_t> const& subset) const
+    {
+      std::vector<Coordinate> dist(subset.size(), std::numeric_limits<Coordinate>::max());
+      std::vector<char> inTree(subset.size(), 0);
+      Coordinate length = 0;
+      dist[0] = 0;
+      for (std::size_t step = 0; step < subset.size(); step++) {
+        std::size_t next = 0;
+        Coordinate best = std::numeric_limits<Coordinate>::max();
+        for (std::size_t i = 0; i < subset.size(); i++) {
+          if (!inTree[i] && dist[i] < best) {
+            best = dist[i];
+            next = i;
+          }
+        }
+        inTree[next] = 1;
+        length += best;
+        for (std::size_t i = 0; i < subset.size(); i++) {
+          dist[i] = std::min(dist[i], (*this)(subset[next], subset[i]));
+        }
+      }
+      return length;
+    }
+
+  private:
+    std::size_t _n;
+    std::vector<Coordinate> _matrix;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _mstEdges;
+    Coordinate _longestEdge = 0;
+  };
+
+  //Hwang's theorem: some minimum Steiner tree has only full components of the following form. A backbone
+  //leaves a root terminal in one direction, the other terminals hang off it by perpendicular legs which
+  //alternate between both sides, and the backbone ends in a corner to the side opposite to the last leg
+  //(or straight on) which leads to the last terminal. The segment after the corner may carry one more leg,
+  //parallel to the backbone and pointing away from the root. The trees are grown from every root in all
+  //four directions, a terminal is only added if every segment passes the empty diamond and bottleneck tests.
+  class Generator
+  {
+  public:
+    explicit Generator(std::vector<Terminal> const& terminals)
+      : _terminals(terminals),
+        _bottleneck(terminals),
+        _inTree(terminals.size(), 0)
+    {}
+
+    std::vector<FullSteinerTree> run();
+
+  private:
+    //position of a terminal along the backbone (t) and its signed distance from the backbone line (o)
+    struct Leg
+    {
+      std::uint32_t terminal;
+      Coordinate t;
+      Coordinate o;
+    };
+
+    Terminal point(Coordinate t, Coordinate o) const;
+    bool emptyDiamond(Terminal const& u, Terminal const& v) const;
+    bool compatible(std::uint32_t b, Coordinate t, Coordinate o, bool last) const;
+    void extend(std::vector<Leg> const& candidates);
+    void recordCorner(Leg const& last, Leg const& branch);
+    void record(std::vector<std::uint32_t> terminals, Coordinate length);
+
+    std::vector<Terminal> const& _terminals;
+    BottleneckDistances const _bottleneck;
+    std::vector<char> _inTree;
+
+    std::uint32_t _root = 0;
+    std::pair<int, int> _direction;         //of the backbone as (dx,dy)
+    std::vector<Leg> _legs;                 //legs of the tree grown so far, by backbone position
+    Coordinate _legLength = 0;              //sum of |o| of the legs
+    std::map<std::vector<std::uint32_t>, Coordinate> _found;  //shortest tree for every terminal set
+  };
+
+  //position of the point at backbone position t and distance o from the backbone
+  Terminal Generator::point(Coordinate t, Coordinate o) const
+  {
+    auto const [dx, dy] = _direction;
+    Terminal const& r = _terminals[_root];
+    return Terminal{r.x + dx * t - dy * o, r.y + dy * t + dx * o};
+  }
+
+  //no terminal may be closer to both ends of a segment of a minimum Steiner tree than their distance,
+  //otherwise the segment could be replaced by a connection to that terminal
+  bool Generator::emptyDiamond(Terminal const& u, Terminal const& v) const
+  {
+    Coordinate const length = distance(u, v);
+    for (Terminal const& w : _terminals) {
+      if (distance(w, u) < length && distance(w, v) < length) return false;
+    }
+    return true;
+  }
+
+  //tests whether terminal b can be added as a leg (or as the last terminal) at backbone position t with
+  //distance o from the backbone. the new segments have to pass the empty diamond test, and every segment
+  //of the tree separating b from a terminal a of the tree must be at most B(a,b)
+  bool Generator::compatible(std::uint32_t b, Coordinate t, Coordinate o, bool last) const
+  {
+    Coordinate const previous = _legs.empty() ? 0 : _legs.back().t;
+    if (!emptyDiamond(point(previous, 0), point(t, 0)) || !emptyDiamond(point(t, 0), point(t, o))) return false;
+
+    Coordinate const leaf = last ? t - previous + std::abs(o) : std::abs(o);
+    Coordinate nearSide = _bottleneck(_root, b);   //minimum of B(a,b) over the terminals a before the segment
+    Coordinate steinerPoint = 0;                   //backbone position of the previous Steiner point, the root is at 0
+    for (Leg const& leg : _legs) {
+      if (leg.t - steinerPoint > nearSide) return false;
+      if (std::abs(leg.o) > _bottleneck(leg.terminal, b)) return false;
+      nearSide = std::min(nearSide, _bottleneck(leg.terminal, b));
+      steinerPoint = leg.t;
+    }
+    return t - previous <= nearSide && leaf <= nearSide;
+  }
+
+  //tries every terminal beyond the last leg as the last terminal and as the next leg
+  void Generator::extend(std::vector<Leg> const& candidates)
+  {
+    Leg const& last = _legs.back();
+    bool const lastPointFull = _legs.size() >= 2 && _legs[_legs.size() - 2].t == last.t;  //legs on both sides already
+
+    auto begin = std::lower_bound(candidates.begin(), candidates.end(), last.t,
+                                  [](Leg const& leg, Coordinate t) { return leg.t < t; });
+    for (auto it = begin; it != candidates.end(); ++it) {
+      Leg const& c = *it;
+      Coordinate const gap = c.t - last.t;
+      if (gap > _bottleneck.longestEdge()) break;
+      if (_inTree[c.terminal]) continue;
+
+      bool const opposite = c.o != 0 && ((c.o > 0) != (last.o > 0));
+      if (gap == 0 && (!opposite || lastPointFull)) continue;
+
+      if ((opposite || (c.o == 0 && gap > 0)) && compatible(c.terminal, c.t, c.o, true)) {
+        record({c.terminal}, c.t + _legLength + std::abs(c.o));
+      }
+
+      //c as the end of the segment after the corner, with a leg to a terminal further away from the root
+      if (opposite) {
+        for (auto branch = it + 1; branch != candidates.end() && branch->t - c.t <= _bottleneck.longestEdge(); ++branch) {
+          if (branch->t == c.t || _inTree[branch->terminal]) continue;
+          if ((branch->o > 0) == (c.o > 0) && std::abs(branch->o) < std::abs(c.o)) recordCorner(c, *branch);
+        }
+      }
+
+      if (opposite && compatible(c.terminal, c.t, c.o, false)) {
+        _legs.push_back(c);
+        _legLength += std::abs(c.o);
+        _inTree[c.terminal] = 1;
+        extend(candidates);
+        _inTree[c.terminal] = 0;
+        _legLength -= std::abs(c.o);
+        _legs.pop_back();
+      }
+    }
+  }
+
+  //the tree with the backbone turning towards last at its position and a leg from (last.t, branch.o) to branch.
+  //the path from the last Steiner point on the backbone to that leg has no branches, so it is tested as one segment
+  void Generator::recordCorner(Leg const& last, Leg const& branch)
+  {
+    Coordinate const previous = _legs.back().t;
+    Terminal const corner = point(last.t, 0);
+    Terminal const steinerPoint = point(last.t, branch.o);
+    if (!emptyDiamond(point(previous, 0), corner) || !emptyDiamond(corner, steinerPoint)
+        || !emptyDiamond(steinerPoint, point(last.t, last.o)) || !emptyDiamond(steinerPoint, point(branch.t, branch.o))) {
+      return;
+    }
+
+    Coordinate const between = _bottleneck(last.terminal, branch.terminal);
+    Coordinate nearLast = _bottleneck(_root, last.terminal);
+    Coordinate nearBranch = _bottleneck(_root, branch.terminal);
+    Coordinate position = 0;
+    for (Leg const& leg : _legs) {
+      if (leg.t - position > std::min(nearLast, nearBranch)) return;
+      if (std::abs(leg.o) > std::min(_bottleneck(leg.terminal, last.terminal), _bottleneck(leg.terminal, branch.terminal))) return;
+      nearLast = std::min(nearLast, _bottleneck(leg.terminal, last.terminal));
+      nearBranch = std::min(nearBranch, _bottleneck(leg.terminal, branch.terminal));
+      position = leg.t;
+    }
+    if (last.t - previous + std::abs(branch.o) > std::min(nearLast, nearBranch)) return;
+    if (std::abs(last.o) - std::abs(branch.o) > std::min(nearLast, between)) return;
+    if (branch.t - last.t > std::min(nearBranch, between)) return;
+
+    record({last.terminal, branch.terminal}, branch.t + _legLength + std::abs(last.o));
+  }
+
+  //stores the tree with the legs and the given last terminals if it is shorter than a spanning tree w.r.t. the
+  //bottleneck distances, otherwise the tree can be replaced by minimum spanning tree edges
+  void Generator::record(std::vector<std::uint32_t> terminals, Coordinate length)
+  {
+    terminals.push_back(_root);
+    for (Leg const& leg : _legs) terminals.push_back(leg.terminal);
+    if (length >= _bottleneck.mstLength(terminals)) return;
+
+    std::sort(terminals.begin(), terminals.end());
+    auto [it, inserted] = _found.emplace(std::move(terminals), length);
+    if (!inserted) it->second = std::min(it->second, length);
+  }
+
+  std::vector<FullSteinerTree> Generator::run()
+  {
+    //the backbone directions as (dx,dy), the legs are measured along (-dy,dx)
+    std::array<std::pair<int, int>, 4> constexpr directions{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+    for (_root = 0; _root < _terminals.size(); _root++) {
+      Terminal const& r = _terminals[_root];
+      _inTree[_root] = 1;
+      for (auto const& direction : directions) {
+        _direction = direction;
+        auto const [dx, dy] = direction;
+        std::vector<Leg> candidates;
+        for (std::uint32_t b = 0; b < _terminals.size(); b++) {
+          Coordinate t = dx * (_terminals[b].x - r.x) + dy * (_terminals[b].y - r.y);
+          Coordinate o = -dy * (_terminals[b].x - r.x) + dx * (_terminals[b].y - r.y);
+          if (t > 0) candidates.push_back(Leg{b, t, o});
+        }
+        std::sort(candidates.begin(), candidates.end(), [](Leg const& a, Leg const& b) { return a.t < b.t; });
+
+        //first leg, the segment from the root to it is at most B(root,c)
+        for (Leg const& c : candidates) {
+          if (c.t > _bottleneck.longestEdge()) break;
+          if (c.o == 0 || !compatible(c.terminal, c.t, c.o, false)) continue;
+          _legs.push_back(c);
+          _legLength = std::abs(c.o);
+          _inTree[c.terminal] = 1;
+          extend(candidates);
+          _inTree[c.terminal] = 0;
+          _legs.pop_back();
+        }
+      }
+      _inTree[_root] = 0;
+    }
+
+    std::vector<FullSteinerTree> fsts;
+    for (auto const& [a, b] : _bottleneck.mstEdges()) {
+      fsts.push_back(FullSteinerTree{{std::min(a, b), std::max(a, b)}, distance(_terminals[a], _terminals[b])});
+    }
+    for (auto& [terminals, length] : _found) fsts.push_back(FullSteinerTree{terminals, length});
+    return fsts;
+  }
+
+  //Dinic's maximum flow with real capacities, used to separate subtour constraints
+  class MaxFlow
+  {
+  public:
+    static constexpr double INFINITE = LinearProgram::INFINITE;
+
+    explicit MaxFlow(std::size_t numNodes) : _adjacent(numNodes), _level(numNodes), _next(numNodes) {}
+
+    void addEdge(std::uint32_t from, std::uint32_t to, double capacity)
+    {
+      _adjacent[from].push_back(_edges.size());
+      _edges.push_back(Edge{to, capacity});
+      _adjacent[to].push_back(_edges.size());
+      _edges.push_back(Edge{from, 0});
+    }
+
+    void run(std::uint32_t source, std::uint32_t sink)
+    {
+      while (levels(source, sink)) {
+        std::fill(_next.begin(), _next.end(), 0);
+        while (augment(source, sink, INFINITE) > EPSILON) {}
+      }
+    }
+
+    //the source side of a minimum cut, the nodes reachable from the source in the residual graph
+    std::vector<char> sourceSide(std::uint32_t source)
+    {
+      levels(source, std::uint32_t(_adjacent.size()));
+      std::vector<char> side(_adjacent.size());
+      for (std::size_t v = 0; v < side.size(); v++) side[v] = _level[v] >= 0;
+      return side;
+    }
+
+  private:
+    static constexpr double EPSILON = 1e-12;
+
+    struct Edge
+    {
+      std::uint32_t to;
+      double capacity;    //residual, the reverse edge is at the index ^ 1
+    };
+
+    //breadth first search in the residual graph, returns whether the sink is reachable
+    bool levels(std::uint32_t source, std::uint32_t sink)
+    {
+      std::fill(_level.begin(), _level.end(), -1);
+      std::vector<std::uint32_t> queue{source};
+      _level[source] = 0;
+      for (std::size_t i = 0; i < queue.size(); i++) {
+        for (std::size_t e : _adjacent[queue[i]]) {
+          if (_edges[e].capacity <= EPSILON || _level[_edges[e].to] >= 0) continue;
+          _level[_edges[e].to] = _level[queue[i]] + 1;
+          queue.push_back(_edges[e].to);
+        }
+      }
+      return sink < _level.size() && _level[sink] >= 0;
+    }
+
+    double augment(std::uint32_t v, std::uint32_t sink, double pushed)
+    {
+      if (v == sink) return pushed;
+      for (; _next[v] < _adjacent[v].size(); _next[v]++) {
+        std::size_t const e = _adjacent[v][_next[v]];
+        Edge const& edge = _edges[e];
+        if (edge.capacity <= EPSILON || _level[edge.to] != _level[v] + 1) continue;
+        double const flow = augment(edge.to, sink, std::min(pushed, edge.capacity));
+        if (flow > EPSILON) {
+          _edges[e].capacity -= flow;
+          _edges[e ^ 1].capacity += flow;
+          return flow;
+        }
+      }
+      return 0;
+    }
+
+    std::vector<Edge> _edges;
+    std::vector<std::vector<std::size_t>> _adjacent;
+    std::vector<int> _level;
+    std::vector<std::size_t> _next;
+  };
+
+  //Branch and bound over spanning trees of the hypergraph with the full Steiner trees as hyperedges, bounded by
+  //the linear relaxation of
+  //  minimize   sum |F| x_F
+  //  subject to sum (|F|-1) x_F = n-1
+  //             sum max(0, |F n S|-1) x_F <= |S|-1  for all sets S of at least two terminals (subtour elimination)
+  //             x_F in {0,1}
+  //with the degree constraints sum_{F contains v} x_F >= 1 to start with. Violated subtour constraints are
+  //found from the components of the support or by a minimum cut, and are kept for the whole search.
+  //it branches on the most fractional x_F, trying x_F = 1 first.
+  class Concatenation
+  {
+  public:
+    Concatenation(std::vector<FullSteinerTree> const& fsts, std::size_t numTerminals, Algorithm::Options const& options)
+      : _fsts(fsts), _numTerminals(numTerminals), _options(options), _lp(fsts.size())
+    {}
+
+    Algorithm::Result run();
+
+  private:
+    Coordinate greedy() const;
+    void addSubtourConstraint(std::vector<char> const& inSet);
+    double violation(std::vector<char> const& inSet) const;
+    bool separate();
+    void search(bool root);
+    bool timeLimitReached() const;
+
+    std::vector<FullSteinerTree> const& _fsts;
+    std::size_t _numTerminals;
+    Algorithm::Options const& _options;
+    std::chrono::steady_clock::time_point const _start = std::chrono::steady_clock::now();
+
+    LinearProgram _lp;
+    Coordinate _upperBound = 0;
+    double _rootBound = 0;
+    std::size_t _nodes = 0;
+    bool _stopped = false;
+  };
+
+  //picks the trees by increasing length per merged component as long as they do not close a cycle,
+  //the minimum spanning tree edges make sure this ends with a spanning tree
+  Coordinate Concatenation::greedy() const
+  {
+    std::vector<std::uint32_t> order(_fsts.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto ratio = [this](std::uint32_t f) { return double(_fsts[f].length) / double(_fsts[f].terminals.size() - 1); };
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return ratio(a) < ratio(b); });
+
+    UnionFind components(_numTerminals);
+    Coordinate length = 0;
+    for (std::uint32_t f : order) {
+      auto const& terminals = _fsts[f].terminals;
+      bool acyclic = true;
+      for (std::size_t i = 0; i < terminals.size() && acyclic; i++) {
+        for (std::size_t j = i + 1; j < terminals.size() && acyclic; j++) {
+          acyclic = components.find(terminals[i]) != components.find(terminals[j]);
+        }
+      }
+      if (!acyclic) continue;
+      for (std::uint32_t t : terminals) components.unite(terminals[0], t);
+      length += _fsts[f].length;
+    }
+    return length;
+  }
+
+  //sum max(0, |F n S|-1) x_F - (|S|-1) for the current solution of the linear program
+  double Concatenation::violation(std::vector<char> const& inSet) const
+  {
+    double lhs = 0;
+    for (std::uint32_t f = 0; f < _fsts.size(); f++) {
+      std::size_t inside = 0;
+      for (std::uint32_t t : _fsts[f].terminals) inside += inSet[t];
+      if (inside > 1) lhs += double(inside - 1) * _lp.value(f);
+    }
+    return lhs - double(std::count(inSet.begin(), inSet.end(), 1) - 1);
+  }
+
+  void Concatenation::addSubtourConstraint(std::vector<char> const& inSet)
+  {
+    std::vector<std::pair<std::uint32_t, double>> coefficients;
+    for (std::uint32_t f = 0; f < _fsts.size(); f++) {
+      std::size_t inside = 0;
+      for (std::uint32_t t : _fsts[f].terminals) inside += inSet[t];
+      if (inside > 1) coefficients.emplace_back(f, double(inside - 1));
+    }
+    _lp.addRow(std::move(coefficients), LinearProgram::Sense::LessEqual, double(std::count(inSet.begin(), inSet.end(), 1) - 1));
+  }
+
+  //adds the subtour constraints violated by the current solution, returns false if there are none.
+  //if the trees with x_F > 0 do not connect all terminals, one of the components violates its constraint.
+  //otherwise, with d_v = sum_{F contains v} x_F and T the terminals outside of S, a most violated S maximizes
+  //  sum_{F inside T} x_F - sum_{v in T} (d_v - 1)
+  //which is a maximum weight closure, a minimum cut between the trees (source side, weight x_F) and the terminals
+  //(sink side, weight d_v - 1). For every terminal t a cut is computed with t in S and the terminals before t in T
+  bool Concatenation::separate()
+  {
+    double constexpr MIN_VIOLATION = 1e-6;
+    std::vector<std::uint32_t> support;
+    for (std::uint32_t f = 0; f < _fsts.size(); f++) {
+      if (_lp.value(f) > 1e-9) support.push_back(f);
+    }
+
+    UnionFind components(_numTerminals);
+    for (std::uint32_t f : support) {
+      for (std::uint32_t t : _fsts[f].terminals) components.unite(_fsts[f].terminals[0], t);
+    }
+    bool found = false;
+    for (std::uint32_t root = 0; root < _numTerminals; root++) {
+      if (components.find(root) != root) continue;
+      std::vector<char> inSet(_numTerminals, 0);
+      for (std::uint32_t t = 0; t < _numTerminals; t++) inSet[t] = components.find(t) == root;
+      if (violation(inSet) > MIN_VIOLATION) {
+        addSubtourConstraint(inSet);
+        found = true;
+      }
+    }
+    if (found) return true;
+
+    std::vector<double> degree(_numTerminals, 0);
+    for (std::uint32_t f : support) {
+      for (std::uint32_t t : _fsts[f].terminals) degree[t] += _lp.value(f);
+    }
+    std::uint32_t const source = 0;
+    std::uint32_t const sink = 1;
+    std::uint32_t const firstTerminal = 2 + support.size();
+    std::vector<std::vector<char>> added;
+    for (std::uint32_t t = 0; t < _numTerminals; t++) {
+      MaxFlow flow(firstTerminal + _numTerminals);
+      for (std::uint32_t i = 0; i < support.size(); i++) {
+        flow.addEdge(source, 2 + i, _lp.value(support[i]));
+        for (std::uint32_t v : _fsts[support[i]].terminals) flow.addEdge(2 + i, firstTerminal + v, MaxFlow::INFINITE);
+      }
+      for (std::uint32_t v = 0; v < _numTerminals; v++) {
+        if (v == t) flow.addEdge(firstTerminal + v, sink, MaxFlow::INFINITE);
+        else if (v < t) flow.addEdge(source, firstTerminal + v, MaxFlow::INFINITE);
+        else if (degree[v] > 1) flow.addEdge(firstTerminal + v, sink, degree[v] - 1);
+        else if (degree[v] < 1) flow.addEdge(source, firstTerminal + v, 1 - degree[v]);
+      }
+      flow.run(source, sink);
+      std::vector<char> const side = flow.sourceSide(source);
+
+      std::vector<char> inSet(_numTerminals);
+      for (std::uint32_t v = 0; v < _numTerminals; v++) inSet[v] = !side[firstTerminal + v];
+      if (violation(inSet) <= MIN_VIOLATION || std::find(added.begin(), added.end(), inSet) != added.end()) continue;
+      addSubtourConstraint(inSet);
+      added.push_back(std::move(inSet));
+    }
+    return !added.empty();
+  }
+
+  bool Concatenation::timeLimitReached() const
+  {
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - _start;
+    return elapsed.count() > _options.timeLimit;
+  }
+
+  void Concatenation::search(bool root)
+  {
+    _nodes++;
+    //lengths are integral, so only trees of length at most upper bound - 1 are of interest
+    while (true) {
+      if (_options.timeLimit > 0 && timeLimitReached()) _stopped = true;
+      if (_stopped) return;
+
+      LinearProgram::Status const status = _lp.solve();
+      if (status == LinearProgram::Status::Infeasible) return;
+      if (status == LinearProgram::Status::IterationLimit) {
+        _stopped = true;   //no bound for this node, optimality cannot be proven
+        return;
+      }
+      if (root) _rootBound = _lp.objective();
+      if (_lp.objective() > _upperBound - 1 + 1e-6) return;
+      if (!separate()) break;
+    }
+
+    std::uint32_t branch = 0;
+    double mostFractional = 0;
+    for (std::uint32_t f = 0; f < _fsts.size(); f++) {
+      double const fractional = std::min(_lp.value(f), 1 - _lp.value(f));
+      if (fractional > mostFractional + 1e-9) {
+        mostFractional = fractional;
+        branch = f;
+      }
+    }
+    if (mostFractional <= 1e-6) {
+      Coordinate length = 0;
+      for (std::uint32_t f = 0; f < _fsts.size(); f++) {
+        if (_lp.value(f) > 0.5) length += _fsts[f].length;
+      }
+      _upperBound = std::min(_upperBound, length);
+      return;
+    }
+
+    _lp.setBounds(branch, 1, 1);
+    search(false);
+    _lp.setBounds(branch, 0, 0);
+    search(false);
+    _lp.setBounds(branch, 0, 1);
+  }
+
+  Algorithm::Result Concatenation::run()
+  {
+    _upperBound = greedy();
+
+    for (std::uint32_t f = 0; f < _fsts.size(); f++) {
+      _lp.setCost(f, _fsts[f].length);
+      _lp.setBounds(f, 0, 1);
+    }
+    std::vector<std::pair<std::uint32_t, double>> spanning;
+    std::vector<std::vector<std::pair<std::uint32_t, double>>> degree(_numTerminals);
+    for (std::uint32_t f = 0; f < _fsts.size(); f++) {
+      spanning.emplace_back(f, double(_fsts[f].terminals.size() - 1));
+      for (std::uint32_t t : _fsts[f].terminals) degree[t].emplace_back(f, 1.0);
+    }
+    _lp.addRow(std::move(spanning), LinearProgram::Sense::Equal, double(_numTerminals - 1));
+    for (auto& row : degree) _lp.addRow(std::move(row), LinearProgram::Sense::GreaterEqual, 1.0);
+
+    search(true);
+
+    Algorithm::Result result;
+    result.fullSteinerTrees = _fsts.size();
+    result.length = _upperBound;
+    result.lowerBound = _stopped ? std::min(_upperBound, Coordinate(std::ceil(_rootBound - 1e-6))) : _upperBound;
+    result.optimal = !_stopped;
+    result.branchNodes = _nodes;
+    return result;
+  }
+}
+
+std::vector<FullSteinerTree> generate_fsts(std::vector<Terminal> const& terminals)
+{
+  return Generator(terminals).run();
+}
+
+Algorithm::Result fst_steiner(std::vector<Terminal> const& terminals, Algorithm::Options const& options)
+{
+  //terminals at the same position are connected for free
+  std::vector<Terminal> distinct = terminals;
+  std::sort(distinct.begin(), distinct.end(), [](Terminal const& a, Terminal const& b) { return a.x != b.x ? a.x < b.x : a.y < b.y; });
+  distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+  if (distinct.size() < 2) return Algorithm::Result{};
+
+  auto const fsts = generate_fsts(distinct);
+  return Concatenation(fsts, distinct.size(), options).run();
+}
+
+}
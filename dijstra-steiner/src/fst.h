@@ -0,0 +1,31 @@
+#ifndef FST_H
+#define FST_H
+
+#include <cstdint>
+#include <vector>
+#include "algorithm.h"
+#include "common.h"
+
+//Exact solver for larger instances in two phases as in GeoSteiner: generate the full Steiner trees (all
+//terminals are leaves) which may be part of a minimum Steiner tree, then concatenate a cheapest subset of
+//them which forms a spanning tree of the terminals.
+namespace Fst {
+
+struct FullSteinerTree
+{
+  std::vector<std::uint32_t> terminals;   //indices into the (duplicate free) terminal list, sorted
+  Coordinate length;
+};
+
+//full Steiner trees of Hwang topology which pass the pruning tests, plus the edges of a minimum spanning tree
+//as the full trees with two terminals. Some minimum Steiner tree is a concatenation of these.
+//the terminals must be pairwise distinct
+std::vector<FullSteinerTree> generate_fsts(std::vector<Terminal> const& terminals);
+
+//length of a minimum Steiner tree by full Steiner tree generation and branch and bound concatenation.
+//the time limit of the options is respected, the other options only apply to dijkstra_steiner
+Algorithm::Result fst_steiner(std::vector<Terminal> const& terminals, Algorithm::Options const& options = {});
+
+}
+
+#endif /*FST_H */
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <stdexcept>
+#include "generator.h"
+
+namespace Generator {
+
+namespace {
+  class SplitMix64
+  {
+  public:
+    explicit SplitMix64(std::uint64_t seed) : _state(seed) {}
+
+    std::uint64_t next()
+    {
+      std::uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+    }
+
+    //in [0, bound), the modulo bias is negligible for the ranges used here
+    Coordinate below(Coordinate bound) { return Coordinate(next() % std::uint64_t(bound)); }
+
+  private:
+    std::uint64_t _state;
+  };
+}
+
+std::string name(Kind kind)
+{
+  return kind == Kind::Random ? "random" : "clustered";
+}
+
+Kind kind_from_name(std::string const& name)
+{
+  if (name == "random") return Kind::Random;
+  if (name == "clustered") return Kind::Clustered;
+  throw std::runtime_error("Unknown instance kind: " + name);
+}
+
+std::vector<Terminal> generate(Kind kind, std::size_t numTerminals, Coordinate range, std::uint64_t seed)
+{
+  //the kind and size go into the seed, so every configuration gets its own instances
+  SplitMix64 random(seed * 1000003 + numTerminals * 31 + (kind == Kind::Random ? 0 : 17) + std::uint64_t(range));
+  std::vector<Terminal> terminals;
+
+  if (kind == Kind::Random) {
+    for (std::size_t i = 0; i < numTerminals; i++) terminals.push_back(Terminal{random.below(range), random.below(range)});
+    return terminals;
+  }
+
+  //1 to 3 clusters with a spread of a tenth of the range, coordinates are multiples of the track pitch
+  Coordinate const pitch = std::max(1, range / 1000);
+  Coordinate const spread = std::max(1, range / 10);
+  std::vector<Terminal> centres(1 + random.below(3));
+  for (Terminal& c : centres) c = Terminal{random.below(range), random.below(range)};
+  for (std::size_t i = 0; i < numTerminals; i++) {
+    Terminal const& c = centres[random.below(Coordinate(centres.size()))];
+    Coordinate x = std::clamp(c.x + random.below(2 * spread + 1) - spread, 0, range - 1);
+    Coordinate y = std::clamp(c.y + random.below(2 * spread + 1) - spread, 0, range - 1);
+    terminals.push_back(Terminal{x / pitch * pitch, y / pitch * pitch});
+  }
+  return terminals;
+}
+
+}
@@ -0,0 +1,26 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "common.h"
+
+//Seeded instances for the benchmark. The random numbers come from splitmix64 and are mapped to coordinates
+//without the distributions of <random>, so a seed gives the same instance with every compiler.
+namespace Generator {
+
+enum class Kind
+{
+  Random,       //uniform in [0, range)^2
+  Clustered     //pins on a track grid around a few cluster centres, many shared coordinates as in VLSI nets
+};
+
+std::string name(Kind kind);
+Kind kind_from_name(std::string const& name);   //throws for an unknown name
+
+std::vector<Terminal> generate(Kind kind, std::size_t numTerminals, Coordinate range, std::uint64_t seed);
+
+}
+
+#endif /*GENERATOR_H */
@@ -0,0 +1,26 @@
+#include <algorithm>
+#include "hanan_grid.h"
+
+HananGrid::HananGrid(std::vector<Terminal> const& terminals)
+{
+  for (Terminal const& t : terminals) {
+    _xs.push_back(t.x);
+    _ys.push_back(t.y);
+  }
+  std::sort(_xs.begin(), _xs.end());
+  _xs.erase(std::unique(_xs.begin(), _xs.end()), _xs.end());
+  std::sort(_ys.begin(), _ys.end());
+  _ys.erase(std::unique(_ys.begin(), _ys.end()), _ys.end());
+}
+
+std::uint32_t HananGrid::vertexOf(Terminal const& t) const
+{
+  std::size_t column = std::lower_bound(_xs.begin(), _xs.end(), t.x) - _xs.begin();
+  std::size_t row = std::lower_bound(_ys.begin(), _ys.end(), t.y) - _ys.begin();
+  return column + row * _xs.size();
+}
+
+bool HananGrid::contains(Terminal const& t) const
+{
+  return std::binary_search(_xs.begin(), _xs.end(), t.x) && std::binary_search(_ys.begin(), _ys.end(), t.y);
+}
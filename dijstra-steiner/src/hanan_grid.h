@@ -0,0 +1,38 @@
+#ifndef HANAN_GRID_H
+#define HANAN_GRID_H
+
+#include <cstdint>
+#include <vector>
+#include "common.h"
+
+//Hanan grid of a terminal set: the vertices are all (x,y) where x is the x coordinate of a terminal
+//and y the y coordinate of a terminal. Adjacent vertices are joined by an edge of length equal to
+//their coordinate gap, so the grid size only depends on the number of terminals.
+class HananGrid
+{
+public:
+  explicit HananGrid(std::vector<Terminal> const& terminals);
+
+  std::size_t numVertices() const { return _xs.size() * _ys.size(); }
+  std::size_t numColumns() const { return _xs.size(); }
+  std::size_t numRows() const { return _ys.size(); }
+
+  //vertex index of a point with terminal coordinates
+  std::uint32_t vertexOf(Terminal const& t) const;
+  Terminal position(std::uint32_t vertex) const { return Terminal{_xs[column(vertex)], _ys[row(vertex)]}; }
+  //whether the point is a vertex, i.e. its x and y are coordinates of terminals
+  bool contains(Terminal const& t) const;
+
+  std::size_t column(std::uint32_t vertex) const { return vertex % _xs.size(); }
+  std::size_t row(std::uint32_t vertex) const { return vertex / _xs.size(); }
+
+  //length of the edge between column i and i+1 resp. row i and i+1
+  Coordinate xGap(std::size_t i) const { return _xs[i + 1] - _xs[i]; }
+  Coordinate yGap(std::size_t i) const { return _ys[i + 1] - _ys[i]; }
+
+private:
+  std::vector<Coordinate> _xs;    //distinct x coordinates, sorted
+  std::vector<Coordinate> _ys;    //distinct y coordinates, sorted
+};
+
+#endif /*HANAN_GRID_H */
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include "heuristic.h"
+
+namespace Heuristic {
+
+namespace {
+  //closest point to c in the bounding box of u and w (the shortest path area of the edge)
+  Terminal closestPoint(Terminal const& c, Terminal const& u, Terminal const& w)
+  {
+    return Terminal{std::clamp(c.x, std::min(u.x, w.x), std::max(u.x, w.x)),
+                    std::clamp(c.y, std::min(u.y, w.y), std::max(u.y, w.y))};
+  }
+
+  Coordinate distance(Terminal const& a, Terminal const& b)
+  {
+    return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+  }
+}
+
+Coordinate steiner_insertion(std::vector<Terminal> const& terminals)
+{
+  if (terminals.size() < 2) return 0;
+
+  std::vector<std::pair<Terminal, Terminal>> edges{{terminals[0], terminals[1]}};
+  std::vector<Terminal> remaining(terminals.begin() + 2, terminals.end());
+
+  while (!remaining.empty()) {
+    //find the terminal s and the edge {u,w} which minimize dist(s, shortest path area(u,w))
+    std::size_t best_s = 0;
+    std::size_t best_e = 0;
+    Coordinate min_dist = std::numeric_limits<Coordinate>::max();
+    for (std::size_t s = 0; s < remaining.size(); s++) {
+      for (std::size_t e = 0; e < edges.size(); e++) {
+        Coordinate d = distance(remaining[s], closestPoint(remaining[s], edges[e].first, edges[e].second));
+        if (d < min_dist) {
+          min_dist = d;
+          best_s = s;
+          best_e = e;
+        }
+      }
+    }
+
+    //replace {u,w} by {u,v}, {w,v} and {s,v} where v is the point of the edge area closest to s
+    Terminal s = remaining[best_s];
+    remaining.erase(remaining.begin() + best_s);
+    auto [u, w] = edges[best_e];
+    edges.erase(edges.begin() + best_e);
+    Terminal v = closestPoint(s, u, w);
+    edges.emplace_back(u, v);
+    edges.emplace_back(w, v);
+    if (!(s == v)) edges.emplace_back(s, v);
+  }
+
+  Coordinate length = 0;
+  for (auto const& [a, b] : edges) length += distance(a, b);
+  return length;
+}
+
+}
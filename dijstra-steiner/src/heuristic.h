@@ -0,0 +1,16 @@
+#ifndef HEURISTIC_H
+#define HEURISTIC_H
+
+#include <vector>
+#include "common.h"
+
+namespace Heuristic {
+
+//length of a (not necessarily minimal) rectilinear Steiner tree, same insertion heuristic as
+//steiner_approx in netlengths: terminals are added one by one, always the one closest to the
+//shortest path area of a tree edge, O(n^3)
+Coordinate steiner_insertion(std::vector<Terminal> const& terminals);
+
+}
+
+#endif /*HEURISTIC_H */
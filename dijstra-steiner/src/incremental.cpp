@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "incremental.h"
+
+IncrementalSteiner::IncrementalSteiner(std::vector<Terminal> const& terminals, Algorithm::Options const& options)
+  : _options(options),
+    _grid(terminals)
+{
+  for (Terminal t : terminals) {
+    if (std::find(_terminals.begin(), _terminals.end(), t) == _terminals.end()) _terminals.push_back(t);
+  }
+  if (_terminals.size() > MAX_NUM_TERMINALS) {
+    throw std::runtime_error("Dijkstra-Steiner cannot handle instances with more than " + std::to_string(MAX_NUM_TERMINALS) + " terminals.");
+  }
+}
+
+template <class Remap>
+void IncrementalSteiner::rebuild(HananGrid const& grid, Remap&& remap)
+{
+  if (!_state || _terminals.size() < 2) {
+    _state.reset();
+    return;
+  }
+  LabelIndex<std::uint64_t> const& old = _state->labels;
+  LabelState<std::uint64_t> state{
+    LabelIndex<std::uint64_t>(grid.numVertices(), _terminals.size(), Algorithm::denseIndexLimit(_options.memoryLimit)),
+    std::vector<std::vector<LabelId>>(grid.numVertices())};
+
+  //the lower bounds depend on the terminals, the search computes them again
+  for (LabelId id = 0; id < old.size(); id++) {
+    Label<std::uint64_t> const& label = old[id];
+    if (label.cost == std::numeric_limits<Coordinate>::max()) continue;
+    std::optional<std::uint64_t> const terminalSet = remap(label.terminalSet);
+    if (!terminalSet) continue;
+
+    std::uint32_t const v = grid.vertexOf(_grid.position(label.vertex()));
+    LabelId const newId = state.labels.get(v, *terminalSet);
+    state.labels[newId].cost = label.cost;
+    if (label.permanent()) {
+      state.labels[newId].makePermanent();
+      state.smt[v].push_back(newId);
+    }
+  }
+
+  //a new grid line splits the edges it crosses. the labels in P were relaxed along the old edges only,
+  //so relax them to their neighbours on the new lines
+  LabelId const numLabels = state.labels.size();
+  for (LabelId id = 0; id < numLabels; id++) {
+    if (!state.labels[id].permanent()) continue;
+    std::uint32_t const v = state.labels[id].vertex();
+    std::uint64_t const terminalSet = state.labels[id].terminalSet;
+    Coordinate const cost = state.labels[id].cost;
+    Terminal const position = grid.position(v);
+
+    std::size_t const column = grid.column(v);
+    std::size_t const row = grid.row(v);
+    std::size_t const numColumns = grid.numColumns();
+    std::vector<std::uint32_t> neighbours;
+    if (column != 0) neighbours.push_back(v - 1);
+    if (column + 1 != numColumns) neighbours.push_back(v + 1);
+    if (row != 0) neighbours.push_back(v - numColumns);
+    if (row + 1 != grid.numRows()) neighbours.push_back(v + numColumns);
+    for (std::uint32_t w : neighbours) {
+      Terminal const wPosition = grid.position(w);
+      if (_grid.contains(wPosition)) continue;
+      Label<std::uint64_t>& label = state.labels[state.labels.get(w, terminalSet)];
+      Coordinate const wCost = cost + std::abs(wPosition.x - position.x) + std::abs(wPosition.y - position.y);
+      if (!label.permanent()) label.cost = std::min(label.cost, wCost);
+    }
+  }
+  _state = std::move(state);
+}
+
+void IncrementalSteiner::add_terminal(Terminal const& terminal)
+{
+  if (std::find(_terminals.begin(), _terminals.end(), terminal) != _terminals.end()) return;
+  if (_terminals.size() == MAX_NUM_TERMINALS) {
+    throw std::runtime_error("Dijkstra-Steiner cannot handle instances with more than " + std::to_string(MAX_NUM_TERMINALS) + " terminals.");
+  }
+  _result.reset();
+  _terminals.push_back(terminal);
+
+  //the new terminal gets the next bit, the labels of the old sets keep theirs
+  std::vector<Terminal> positions = _terminals;
+  for (std::uint32_t v = 0; v < _grid.numVertices(); v++) positions.push_back(_grid.position(v));
+  HananGrid grid(positions);
+  rebuild(grid, [](std::uint64_t terminalSet) { return std::optional<std::uint64_t>(terminalSet); });
+  _grid = std::move(grid);
+}
+
+void IncrementalSteiner::remove_terminal(Terminal const& terminal)
+{
+  auto const it = std::find(_terminals.begin(), _terminals.end(), terminal);
+  if (it == _terminals.end()) {
+    throw std::runtime_error("No terminal at " + std::to_string(terminal.x) + " " + std::to_string(terminal.y));
+  }
+  _result.reset();
+  std::size_t const k = it - _terminals.begin();
+  _terminals.erase(it);
+
+  //labels with terminal k are gone, the bits above k move down by one. if the root was removed,
+  //terminal 1 becomes the root and the labels with it are dropped as well
+  std::uint64_t const below = (std::uint64_t(1) << k) - 1;
+  rebuild(_grid, [k, below](std::uint64_t terminalSet) -> std::optional<std::uint64_t> {
+    if ((terminalSet >> k) & 1) return std::nullopt;
+    std::uint64_t const above = k + 1 < MAX_NUM_TERMINALS ? (terminalSet >> (k + 1)) << k : 0;
+    std::uint64_t const compacted = (terminalSet & below) | above;
+    if (compacted & 1) return std::nullopt;
+    return compacted;
+  });
+}
+
+Algorithm::Result IncrementalSteiner::solve()
+{
+  if (_result) return *_result;
+  if (_terminals.size() < 2) {
+    _result = Algorithm::Result{};
+    return *_result;
+  }
+  if (!_state) {
+    _state = LabelState<std::uint64_t>{
+      LabelIndex<std::uint64_t>(_grid.numVertices(), _terminals.size(), Algorithm::denseIndexLimit(_options.memoryLimit)),
+      std::vector<std::vector<LabelId>>(_grid.numVertices())};
+  }
+
+  //a search that failed may have left its labels in any state
+  try {
+    _result = Algorithm::dijkstra_steiner(_terminals, _options, _grid, *_state);
+  } catch (...) {
+    _state.reset();
+    throw;
+  }
+  return *_result;
+}
@@ -0,0 +1,47 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "algorithm.h"
+#include "common.h"
+#include "hanan_grid.h"
+#include "label_index.h"
+
+//Dijkstra-Steiner for a net that changes by one terminal at a time (engineering change orders). The labels of
+//the last search are kept: a permanent label l(v,I) is the length of a minimum Steiner tree for {v} u I and stays
+//valid as long as the terminals of I do, so after an edit the search continues from the surviving labels
+//instead of starting over with the singletons.
+//
+//the grid is the Hanan grid of every terminal the net ever had, it grows on add_terminal and is kept on
+//remove_terminal. there are no reductions and at most 64 terminals, the engine and the cache of the options
+//are not used
+class IncrementalSteiner
+{
+public:
+  explicit IncrementalSteiner(std::vector<Terminal> const& terminals, Algorithm::Options const& options = {});
+
+  //a terminal at the position of an existing one is ignored
+  void add_terminal(Terminal const& terminal);
+  //throws if there is no terminal at the position
+  void remove_terminal(Terminal const& terminal);
+
+  //length of a minimum Steiner tree for the current terminals, searches only after an edit
+  Algorithm::Result solve();
+
+  std::vector<Terminal> const& terminals() const { return _terminals; }
+
+private:
+  //moves the labels to an index for the new grid and terminals, a label is dropped if remap returns no set
+  template <class Remap>
+  void rebuild(HananGrid const& grid, Remap&& remap);
+
+  std::vector<Terminal> _terminals;   //terminal i is bit i of the label sets, terminal 0 is the root
+  Algorithm::Options _options;
+  HananGrid _grid;
+  std::optional<LabelState<std::uint64_t>> _state;   //none before the first search
+  std::optional<Algorithm::Result> _result;          //none after an edit
+};
+
+#endif /*INCREMENTAL_H */
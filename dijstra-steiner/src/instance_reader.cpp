@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "instance_reader.h"
+#include "mapped_file.h"
+
+namespace InstanceReader {
+
+namespace {
+  char constexpr BINARY_MAGIC[8] = {'P', 'I', 'N', 'S', '0', '0', '0', '1'};
+  std::size_t constexpr BINARY_HEADER_SIZE = sizeof(BINARY_MAGIC) + sizeof(std::uint64_t);
+  std::size_t constexpr STDIN_BLOCK_SIZE = std::size_t(1) << 20;
+
+  //position in the text, numbers are read as by operator>> of a stream (leading whitespace, optional sign)
+  class Cursor
+  {
+  public:
+    explicit Cursor(std::string_view text) : _begin(text.data()), _end(text.data() + text.size()) {}
+
+    bool atEnd() const { return _begin == _end; }
+
+    //spaces and tabs, or all whitespace including line breaks
+    void skipBlanks()
+    {
+      while (_begin != _end && (*_begin == ' ' || *_begin == '\t' || *_begin == '\r' || *_begin == '\v' || *_begin == '\f')) _begin++;
+    }
+    void skipWhitespace()
+    {
+      while (_begin != _end && (*_begin == '\n' || *_begin == ' ' || *_begin == '\t' || *_begin == '\r' || *_begin == '\v' || *_begin == '\f')) _begin++;
+    }
+
+    template <class T>
+    bool number(T& value)
+    {
+      skipBlanks();
+      char const* first = _begin;
+      if (first != _end && *first == '+' && first + 1 != _end && *(first + 1) != '-') first++;
+      auto const [last, error] = std::from_chars(first, _end, value);
+      if (error != std::errc()) return false;
+      _begin = last;
+      return true;
+    }
+
+    //the rest of the current line without the line break, the cursor moves behind it
+    std::string_view line()
+    {
+      char const* first = _begin;
+      char const* last = static_cast<char const*>(std::memchr(_begin, '\n', _end - _begin));
+      if (last == nullptr) last = _end;
+      _begin = last == _end ? _end : last + 1;
+      return std::string_view(first, last - first);
+    }
+
+  private:
+    char const* _begin;
+    char const* _end;
+  };
+
+  Points parseBinary(std::string_view data)
+  {
+    std::uint64_t n = 0;
+    if (data.size() >= BINARY_HEADER_SIZE) std::memcpy(&n, data.data() + sizeof(BINARY_MAGIC), sizeof(n));
+    if (data.size() < BINARY_HEADER_SIZE || n > (data.size() - BINARY_HEADER_SIZE) / (2 * sizeof(std::int32_t))) {
+      throw std::runtime_error("Malformed input: Binary instance is truncated.");
+    }
+    Points points;
+    points.x.resize(n);
+    points.y.resize(n);
+    char const* values = data.data() + BINARY_HEADER_SIZE;
+    if (n != 0) {
+      std::memcpy(points.x.data(), values, n * sizeof(std::int32_t));
+      std::memcpy(points.y.data(), values + n * sizeof(std::int32_t), n * sizeof(std::int32_t));
+    }
+    return points;
+  }
+
+  Points parseCounted(std::string_view text)
+  {
+    Points points;
+    Cursor cursor(text);
+    std::size_t n = 0;
+    if (!cursor.number(n)) n = 0;   //as a failed stream read
+    points.x.reserve(std::min(n, text.size() / 4));   //a row takes at least 4 characters
+    points.y.reserve(std::min(n, text.size() / 4));
+    for (std::size_t i = 0; i < n; i++) {
+      cursor.skipWhitespace();
+      if (cursor.atEnd()) {
+        throw std::runtime_error("Malformed input: Input contains less than " + std::to_string(n) + " data rows.");
+      }
+      Cursor line(cursor.line());
+      std::int32_t x = 0;
+      std::int32_t y = 0;
+      if (!line.number(x) || !line.number(y)) {
+        throw std::runtime_error("Malformed input: Data line contains less than 2 numbers.");
+      }
+      line.skipBlanks();
+      if (not line.atEnd()) {
+        throw std::runtime_error("Malformed input: Data line contains more than 2 numbers.");
+      }
+      points.x.push_back(x);
+      points.y.push_back(y);
+    }
+    cursor.skipWhitespace();
+    if (not cursor.atEnd()) {
+      throw std::runtime_error("Malformed input: Input contains more than " + std::to_string(n) + " data rows.");
+    }
+    return points;
+  }
+
+  //anything after the two numbers of a line is ignored
+  Points parseLines(std::string_view text, InvalidLine const& invalidLine)
+  {
+    Points points;
+    Cursor cursor(text);
+    while (!cursor.atEnd()) {
+      std::string_view const row = cursor.line();
+      Cursor line(row);
+      std::int32_t x = 0;
+      std::int32_t y = 0;
+      if (line.number(x) && line.number(y)) {
+        points.x.push_back(x);
+        points.y.push_back(y);
+      } else if (invalidLine) {
+        invalidLine(row);
+      }
+    }
+    return points;
+  }
+}
+
+Points parse(std::string_view data, Format format, InvalidLine const& invalidLine)
+{
+  if (data.size() >= sizeof(BINARY_MAGIC) && std::memcmp(data.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+    return parseBinary(data);
+  }
+  return format == Format::Counted ? parseCounted(data) : parseLines(data, invalidLine);
+}
+
+Points read_file(std::string const& path, Format format, InvalidLine const& invalidLine)
+{
+  MappedFile const file(path);
+  if (file.size() == 0 && !std::filesystem::exists(path)) throw std::runtime_error("Cannot open file: " + path);
+  return parse(file.view(), format, invalidLine);
+}
+
+Points read_stdin(Format format, InvalidLine const& invalidLine)
+{
+  std::string data;
+  std::size_t size = 0;
+  while (true) {
+    data.resize(size + STDIN_BLOCK_SIZE);
+    std::size_t const read = std::fread(data.data() + size, 1, STDIN_BLOCK_SIZE, stdin);
+    size += read;
+    if (read < STDIN_BLOCK_SIZE) break;
+  }
+  data.resize(size);
+  return parse(data, format, invalidLine);
+}
+
+void write_binary(std::string const& path, Points const& points)
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (out.fail()) throw std::runtime_error("Cannot write file: " + path);
+  std::uint64_t const n = points.size();
+  out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  out.write(reinterpret_cast<char const*>(&n), sizeof(n));
+  out.write(reinterpret_cast<char const*>(points.x.data()), n * sizeof(std::int32_t));
+  out.write(reinterpret_cast<char const*>(points.y.data()), n * sizeof(std::int32_t));
+  if (out.fail()) throw std::runtime_error("Cannot write file: " + path);
+}
+
+}
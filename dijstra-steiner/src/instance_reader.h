@@ -0,0 +1,46 @@
+#ifndef INSTANCE_READER_H
+#define INSTANCE_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//Instance reader shared by dijkstra-steiner and netlengths. A file is memory mapped and stdin is read in
+//large blocks, the numbers are parsed in place with std::from_chars into separate x and y arrays, without
+//a string or a stream per line.
+//
+//binary instance, read without parsing, integers in native byte order:
+//  "PINS0001", uint64 number of points n, n int32 x coordinates, n int32 y coordinates
+namespace InstanceReader {
+
+struct Points
+{
+  std::vector<std::int32_t> x;
+  std::vector<std::int32_t> y;
+
+  std::size_t size() const { return x.size(); }
+};
+
+enum class Format
+{
+  Counted,    //the number of points, then one "x y" per line (dijkstra-steiner), malformed input throws
+  Lines       //one "x y" per line (netlengths), a malformed line is passed to the callback and skipped
+};
+
+using InvalidLine = std::function<void(std::string_view line)>;
+
+//text in the given format, or a binary instance whatever the format
+Points parse(std::string_view data, Format format, InvalidLine const& invalidLine = {});
+
+//throws if the file does not exist
+Points read_file(std::string const& path, Format format, InvalidLine const& invalidLine = {});
+Points read_stdin(Format format, InvalidLine const& invalidLine = {});
+
+void write_binary(std::string const& path, Points const& points);
+
+}
+
+#endif /*INSTANCE_READER_H */
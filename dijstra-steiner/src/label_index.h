@@ -0,0 +1,141 @@
+#ifndef LABEL_INDEX_H
+#define LABEL_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "arena.h"
+#include "common.h"
+
+using LabelId = std::uint32_t;
+
+//a label l(v,I) as stored in the index, it is tentative until it got popped from the queue.
+//Mask is the unsigned integer type holding the terminal set I, bit i stands for terminal i.
+//the vertex index and the permanent flag share one word, so a label takes 16 bytes up to 32 terminals
+template <class Mask>
+struct Label
+{
+  static constexpr std::uint32_t PERMANENT = std::uint32_t(1) << 31;
+
+  std::uint32_t vertexAndState;   //vertex index, the highest bit is set once (v,I) is in P
+  Coordinate cost;                //l(v,I), only meaningful once the label was reached
+  Coordinate lb;                  //lb(v,T\I), computed when the label is reached, -1 before
+  Mask terminalSet;               //I
+
+  std::uint32_t vertex() const { return vertexAndState & ~PERMANENT; }
+  bool permanent() const { return vertexAndState & PERMANENT; }
+  void makePermanent() { vertexAndState |= PERMANENT; }
+};
+
+//table of label ids keyed by (vertex, I), so every label can be found in O(1). it is either dense
+//or an open addressing hash table. labels live in an arena and get consecutive ids in the order
+//they are reached
+template <class Mask>
+class LabelIndex
+{
+public:
+  static constexpr LabelId NO_LABEL = std::numeric_limits<LabelId>::max();
+
+  //the table is dense, one slot for every (v,I), if that takes at most denseLimit bytes.
+  //otherwise it is a hash table which only holds the labels that were reached
+  LabelIndex(std::size_t numVertices, std::size_t numTerminals, std::size_t denseLimit)
+  {
+    _subsetBits = numTerminals - 1;   //the root is never in I
+    if (_subsetBits < 32 && numVertices <= (denseLimit / sizeof(LabelId)) >> _subsetBits) {
+      _dense = true;
+      _slots.assign(numVertices << _subsetBits, NO_LABEL);
+      return;
+    }
+
+    //keep the load factor below 1/2
+    _shift = 60;
+    _slots.assign(16, NO_LABEL);
+  }
+
+  //returns the id of (v,I), a new unreached label is inserted if (v,I) was not seen before
+  LabelId get(std::uint32_t vertex, Mask terminalSet)
+  {
+    std::size_t slot = slotOf(vertex, terminalSet);
+    if (_slots[slot] == NO_LABEL) {
+      if (!_dense && 2 * (_labels.size() + 1) > _slots.size()) {
+        grow();
+        slot = slotOf(vertex, terminalSet);
+      }
+      _slots[slot] = _labels.push_back(Label<Mask>{vertex, std::numeric_limits<Coordinate>::max(), -1, terminalSet});
+    }
+    return _slots[slot];
+  }
+
+  //returns NO_LABEL if (v,I) was never reached
+  LabelId find(std::uint32_t vertex, Mask terminalSet) const
+  {
+    return _slots[slotOf(vertex, terminalSet)];
+  }
+
+  Label<Mask>& operator[](LabelId id) { return _labels[id]; }
+  Label<Mask> const& operator[](LabelId id) const { return _labels[id]; }
+
+  std::size_t size() const { return _labels.size(); }
+
+  //bytes allocated for the labels and the hash table
+  std::size_t memoryUsage() const { return _labels.memoryUsage() + _slots.capacity() * sizeof(LabelId); }
+
+private:
+  static constexpr std::uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ull; //fibonacci hashing
+
+  static std::size_t hash(std::uint32_t vertex, Mask terminalSet, int shift)
+  {
+    //the vertex goes right above the mask bits. bit i of the key only reaches the top bits of the product
+    //through the low 64-i bits of the multiplier, with the vertex at bit 40 half of the labels shared their
+    //first slot with another one and the probe sequences got long
+    constexpr int VERTEX_SHIFT = std::min(std::numeric_limits<Mask>::digits, 32);
+    std::uint64_t key = (std::uint64_t(vertex) << VERTEX_SHIFT) ^ terminalSet;
+    return (key * HASH_MULTIPLIER) >> shift;
+  }
+
+  std::size_t slotOf(std::uint32_t vertex, Mask terminalSet) const
+  {
+    if (_dense) return (std::size_t(vertex) << _subsetBits) | (terminalSet >> 1);
+
+    //linear probing, stops at the label or at the first empty slot
+    std::size_t mask = _slots.size() - 1;
+    std::size_t slot = hash(vertex, terminalSet, _shift);
+    while (_slots[slot] != NO_LABEL) {
+      Label<Mask> const& label = _labels[_slots[slot]];
+      if (label.vertex() == vertex && label.terminalSet == terminalSet) break;
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void grow()
+  {
+    std::vector<LabelId> old(2 * _slots.size(), NO_LABEL);
+    old.swap(_slots);
+    _shift--;
+    std::size_t mask = _slots.size() - 1;
+    for (LabelId id : old) {
+      if (id == NO_LABEL) continue;
+      std::size_t slot = hash(_labels[id].vertex(), _labels[id].terminalSet, _shift);
+      while (_slots[slot] != NO_LABEL) slot = (slot + 1) & mask;
+      _slots[slot] = id;
+    }
+  }
+
+  std::vector<LabelId> _slots;
+  Arena<Label<Mask>> _labels;
+  bool _dense = false;
+  std::size_t _subsetBits = 0;
+  int _shift = 0;       //hash = (key * multiplier) >> _shift, table size is 2^(64 - _shift)
+};
+
+//labels of a search together with the lists of P per vertex, so that a later search can continue from them
+template <class Mask>
+struct LabelState
+{
+  LabelIndex<Mask> labels;
+  std::vector<std::vector<LabelId>> smt;
+};
+
+#endif /*LABEL_INDEX_H */
@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "linear_program.h"
+
+namespace {
+  double constexpr PIVOT_TOLERANCE = 1e-9;
+  double constexpr FEASIBILITY_TOLERANCE = 1e-7;
+  double constexpr OPTIMALITY_TOLERANCE = 1e-9;
+
+  //after this many pivots without progress the entering column is chosen by Bland's rule, which cannot cycle
+  std::size_t constexpr DEGENERATE_PIVOTS_BEFORE_BLAND = 50;
+}
+
+//row i of the tableau reads x_basis[i] + sum over the nonbasic columns j of t(i,j) x_j = rhs_i.
+//the columns are the variables, one slack per row (a_i^T x + s_i = b_i) and the artificial variables of
+//phase 1. nonbasic columns sit at one of their bounds, values holds the current value of every column
+class LinearProgram::Tableau
+{
+public:
+  explicit Tableau(LinearProgram const& lp)
+    : _numVariables(lp._numVariables)
+  {
+    //the variables start at their lower bound (or the upper one if there is none)
+    _lower = lp._lower;
+    _upper = lp._upper;
+    for (std::size_t j = 0; j < _numVariables; j++) {
+      _value.push_back(std::isfinite(_lower[j]) ? _lower[j] : (std::isfinite(_upper[j]) ? _upper[j] : 0.0));
+    }
+    _position.assign(_numVariables, NONBASIC);
+
+    //slacks are basic where the starting point satisfies the row, otherwise an artificial variable takes over
+    std::size_t const numRows = lp._rows.size();
+    std::vector<double> residual(numRows);
+    for (std::size_t i = 0; i < numRows; i++) {
+      Row const& row = lp._rows[i];
+      double activity = 0;
+      for (auto const& [j, a] : row.coefficients) activity += a * _value[j];
+      double const slack = row.rhs - activity;
+      addColumn(slackLower(row.sense), slackUpper(row.sense));
+      _value.back() = std::clamp(slack, _lower.back(), _upper.back());
+      residual[i] = std::abs(slack - _value.back()) <= FEASIBILITY_TOLERANCE ? 0.0 : slack - _value.back();
+    }
+    _firstArtificial = _value.size();
+    for (std::size_t i = 0; i < numRows; i++) {
+      if (residual[i] == 0) continue;
+      addColumn(0, INFINITE);
+      _value.back() = std::abs(residual[i]);
+    }
+
+    std::size_t artificial = _firstArtificial;
+    for (std::size_t i = 0; i < numRows; i++) {
+      std::vector<double> row(_value.size(), 0.0);
+      for (auto const& [j, a] : lp._rows[i].coefficients) row[j] += a;
+      row[_numVariables + i] = 1;
+      double rhs = lp._rows[i].rhs;
+      std::size_t basic = _numVariables + i;
+      if (residual[i] != 0) {
+        //a_i^T x + s_i + sign r = b_i, divided by the sign so that r has coefficient 1
+        double const sign = residual[i] > 0 ? 1.0 : -1.0;
+        row[artificial] = sign;
+        for (double& a : row) a *= sign;
+        rhs *= sign;
+        basic = artificial++;
+      }
+      _t.push_back(std::move(row));
+      _rhs.push_back(rhs);
+      _basis.push_back(basic);
+      _position[basic] = i;
+    }
+    _rowsOfProgram = numRows;
+  }
+
+  //phase 1 minimizes the sum of the artificial variables, phase 2 the costs of the program
+  Status solve(LinearProgram const& lp, std::size_t maxIterations)
+  {
+    if (_firstArtificial != _value.size()) {
+      std::vector<double> cost(_value.size(), 0.0);
+      std::fill(cost.begin() + _firstArtificial, cost.end(), 1.0);
+      Status status = primal(cost, maxIterations);
+      if (status != Status::Optimal) return status;
+      for (std::size_t j = _firstArtificial; j < _value.size(); j++) {
+        if (_value[j] > FEASIBILITY_TOLERANCE) return Status::Infeasible;
+        _upper[j] = 0;
+      }
+    }
+    return primal(costs(lp), maxIterations);
+  }
+
+  //brings the rows added since the last solve and the changed bounds into the tableau and optimizes again,
+  //the basis stays dual feasible so the dual simplex only has to repair the primal values
+  Status resolve(LinearProgram const& lp, std::size_t maxIterations)
+  {
+    for (; _rowsOfProgram < lp._rows.size(); _rowsOfProgram++) appendRow(lp._rows[_rowsOfProgram]);
+
+    for (std::size_t j = 0; j < _numVariables; j++) {
+      if (_lower[j] == lp._lower[j] && _upper[j] == lp._upper[j]) continue;
+      _lower[j] = lp._lower[j];
+      _upper[j] = lp._upper[j];
+      if (_position[j] != NONBASIC) continue;
+      double target = _reduced[j] >= 0 ? _lower[j] : _upper[j];
+      if (!std::isfinite(target)) target = std::isfinite(_lower[j]) ? _lower[j] : _upper[j];
+      move(j, target - _value[j]);
+    }
+
+    Status const status = dual(maxIterations);
+    if (status != Status::Optimal) return status;
+    return primal(costs(lp), maxIterations);
+  }
+
+  double value(std::size_t column) const { return _value[column]; }
+
+private:
+  static constexpr std::size_t NONBASIC = std::size_t(-1);
+
+  static double slackLower(Sense sense) { return sense == Sense::GreaterEqual ? -INFINITE : 0.0; }
+  static double slackUpper(Sense sense) { return sense == Sense::LessEqual ? INFINITE : 0.0; }
+
+  std::vector<double> costs(LinearProgram const& lp) const
+  {
+    std::vector<double> cost(_value.size(), 0.0);
+    std::copy(lp._cost.begin(), lp._cost.end(), cost.begin());
+    return cost;
+  }
+
+  void addColumn(double lower, double upper)
+  {
+    _lower.push_back(lower);
+    _upper.push_back(upper);
+    _value.push_back(0);
+    _position.push_back(NONBASIC);
+    _reduced.push_back(0);
+    for (auto& row : _t) row.push_back(0);
+  }
+
+  //the new slack is basic, the basic columns of the other rows are eliminated from the new row
+  void appendRow(Row const& programRow)
+  {
+    addColumn(slackLower(programRow.sense), slackUpper(programRow.sense));
+    std::size_t const slack = _value.size() - 1;
+
+    std::vector<double> row(_value.size(), 0.0);
+    for (auto const& [j, a] : programRow.coefficients) row[j] += a;
+    row[slack] = 1;
+    double rhs = programRow.rhs;
+    for (std::size_t i = 0; i < _t.size(); i++) {
+      double const factor = row[_basis[i]];
+      if (factor == 0) continue;
+      for (std::size_t j = 0; j < row.size(); j++) row[j] -= factor * _t[i][j];
+      rhs -= factor * _rhs[i];
+      row[_basis[i]] = 0;
+    }
+
+    double basicValue = rhs;
+    for (std::size_t j = 0; j < row.size(); j++) {
+      if (_position[j] == NONBASIC && j != slack) basicValue -= row[j] * _value[j];
+    }
+    _t.push_back(std::move(row));
+    _rhs.push_back(rhs);
+    _basis.push_back(slack);
+    _position[slack] = _t.size() - 1;
+    _value[slack] = basicValue;
+  }
+
+  //changes the nonbasic column j by delta and the basic columns accordingly
+  void move(std::size_t j, double delta)
+  {
+    if (delta == 0) return;
+    _value[j] += delta;
+    for (std::size_t i = 0; i < _t.size(); i++) _value[_basis[i]] -= _t[i][j] * delta;
+  }
+
+  Status primal(std::vector<double> const& cost, std::size_t maxIterations)
+  {
+    //reduced costs d_j = c_j - sum_i c_basis[i] t(i,j)
+    _reduced = cost;
+    for (std::size_t i = 0; i < _t.size(); i++) {
+      double const c = cost[_basis[i]];
+      if (c == 0) continue;
+      for (std::size_t j = 0; j < _value.size(); j++) _reduced[j] -= c * _t[i][j];
+    }
+
+    std::size_t degenerate = 0;
+    for (std::size_t iteration = 0; iteration < maxIterations; iteration++) {
+      //entering column: largest reduced cost in a direction the column can move, Bland's rule when stalling
+      bool const bland = degenerate >= DEGENERATE_PIVOTS_BEFORE_BLAND;
+      std::size_t entering = NONBASIC;
+      double direction = 0;
+      double best = OPTIMALITY_TOLERANCE;
+      for (std::size_t j = 0; j < _value.size(); j++) {
+        if (_position[j] != NONBASIC) continue;
+        double const d = _reduced[j];
+        double score = 0;
+        if (d < -best && _value[j] < _upper[j] - FEASIBILITY_TOLERANCE) score = -d;
+        else if (d > best && _value[j] > _lower[j] + FEASIBILITY_TOLERANCE) score = d;
+        if (score == 0) continue;
+        entering = j;
+        direction = d < 0 ? 1.0 : -1.0;
+        if (bland) break;
+        best = score;
+      }
+      if (entering == NONBASIC) {
+        refreshValues();
+        return Status::Optimal;
+      }
+
+      //ratio test, the basic column in row i changes by alpha per unit step of the entering column.
+      //among the rows which block first the one with the largest |alpha| is taken for stability
+      double step = _upper[entering] - _lower[entering];
+      for (std::size_t i = 0; i < _t.size(); i++) {
+        step = std::min(step, limit(i, -_t[i][entering] * direction));
+      }
+      if (!std::isfinite(step)) return Status::IterationLimit;   //unbounded, cannot happen for the programs used here
+      std::size_t leaving = NONBASIC;
+      double largest = 0;
+      for (std::size_t i = 0; i < _t.size(); i++) {
+        double const alpha = -_t[i][entering] * direction;
+        if (std::abs(alpha) > largest && limit(i, alpha) <= step + 1e-12) {
+          largest = std::abs(alpha);
+          leaving = i;
+        }
+      }
+
+      double const improvement = std::abs(_reduced[entering]) * step;
+      degenerate = improvement > OPTIMALITY_TOLERANCE ? 0 : degenerate + 1;
+      move(entering, direction * step);
+
+      if (leaving == NONBASIC || step >= _upper[entering] - _lower[entering]) {
+        _value[entering] = direction > 0 ? _upper[entering] : _lower[entering];   //bound flip, no pivot
+        continue;
+      }
+      std::size_t const out = _basis[leaving];
+      _value[out] = -_t[leaving][entering] * direction < 0 ? _lower[out] : _upper[out];
+      pivot(leaving, entering);
+    }
+    return Status::IterationLimit;
+  }
+
+  //dual simplex: the row whose basic column violates its bounds most leaves the basis, the entering column
+  //is the one that keeps the reduced costs dual feasible
+  Status dual(std::size_t maxIterations)
+  {
+    for (std::size_t iteration = 0; iteration < maxIterations; iteration++) {
+      std::size_t leaving = NONBASIC;
+      double worst = FEASIBILITY_TOLERANCE;
+      for (std::size_t i = 0; i < _t.size(); i++) {
+        std::size_t const b = _basis[i];
+        double const violation = std::max(_lower[b] - _value[b], _value[b] - _upper[b]);
+        if (violation > worst) {
+          worst = violation;
+          leaving = i;
+        }
+      }
+      if (leaving == NONBASIC) return Status::Optimal;
+
+      std::size_t const out = _basis[leaving];
+      bool const increase = _value[out] < _lower[out];
+      double const target = increase ? _lower[out] : _upper[out];
+
+      //x_out changes by -t(leaving,j) per unit increase of column j
+      std::size_t entering = NONBASIC;
+      double bestRatio = INFINITE;
+      double bestAlpha = 0;
+      for (std::size_t j = 0; j < _value.size(); j++) {
+        if (_position[j] != NONBASIC || _upper[j] - _lower[j] <= FEASIBILITY_TOLERANCE) continue;
+        double const alpha = _t[leaving][j];
+        if (std::abs(alpha) <= PIVOT_TOLERANCE) continue;
+        bool const atLower = _value[j] <= _lower[j] + FEASIBILITY_TOLERANCE;
+        bool const atUpper = _value[j] >= _upper[j] - FEASIBILITY_TOLERANCE;
+        bool const usable = increase ? ((atLower && alpha < 0) || (atUpper && alpha > 0))
+                                     : ((atLower && alpha > 0) || (atUpper && alpha < 0));
+        if (!usable) continue;
+        double const ratio = std::abs(_reduced[j]) / std::abs(alpha);
+        if (ratio < bestRatio - 1e-12 || (ratio <= bestRatio + 1e-12 && std::abs(alpha) > bestAlpha)) {
+          bestRatio = ratio;
+          bestAlpha = std::abs(alpha);
+          entering = j;
+        }
+      }
+      if (entering == NONBASIC) return Status::Infeasible;
+
+      move(entering, (_value[out] - target) / _t[leaving][entering]);
+      _value[out] = target;
+      pivot(leaving, entering);
+    }
+    return Status::IterationLimit;
+  }
+
+  //step after which the basic column of row i hits a bound
+  double limit(std::size_t i, double alpha) const
+  {
+    std::size_t const column = _basis[i];
+    if (alpha < -PIVOT_TOLERANCE) return std::max(0.0, (_value[column] - _lower[column]) / -alpha);
+    if (alpha > PIVOT_TOLERANCE) return std::max(0.0, (_upper[column] - _value[column]) / alpha);
+    return INFINITE;
+  }
+
+  void pivot(std::size_t pivotRow, std::size_t pivotColumn)
+  {
+    std::vector<double>& row = _t[pivotRow];
+    double const inverse = 1.0 / row[pivotColumn];
+    std::vector<std::size_t> nonzeros;
+    for (std::size_t j = 0; j < row.size(); j++) {
+      if (row[j] == 0) continue;
+      row[j] *= inverse;
+      nonzeros.push_back(j);
+    }
+    row[pivotColumn] = 1;
+    _rhs[pivotRow] *= inverse;
+
+    for (std::size_t i = 0; i < _t.size(); i++) {
+      double const factor = _t[i][pivotColumn];
+      if (i == pivotRow || factor == 0) continue;
+      for (std::size_t j : nonzeros) _t[i][j] -= factor * row[j];
+      _t[i][pivotColumn] = 0;
+      _rhs[i] -= factor * _rhs[pivotRow];
+    }
+    double const factor = _reduced[pivotColumn];
+    for (std::size_t j : nonzeros) _reduced[j] -= factor * row[j];
+    _reduced[pivotColumn] = 0;
+
+    _position[_basis[pivotRow]] = NONBASIC;
+    _basis[pivotRow] = pivotColumn;
+    _position[pivotColumn] = pivotRow;
+  }
+
+  //recomputes the basic values from the right hand sides, against the rounding errors of the updates
+  void refreshValues()
+  {
+    for (std::size_t i = 0; i < _t.size(); i++) {
+      double value = _rhs[i];
+      for (std::size_t j = 0; j < _value.size(); j++) {
+        if (_position[j] == NONBASIC && _t[i][j] != 0) value -= _t[i][j] * _value[j];
+      }
+      _value[_basis[i]] = value;
+    }
+  }
+
+  std::size_t _numVariables;
+  std::size_t _firstArtificial = 0;
+  std::size_t _rowsOfProgram = 0;       //rows of the program which are in the tableau
+  std::vector<std::vector<double>> _t;
+  std::vector<double> _rhs;
+  std::vector<double> _lower;
+  std::vector<double> _upper;
+  std::vector<double> _value;
+  std::vector<double> _reduced;
+  std::vector<std::size_t> _basis;      //column of every row
+  std::vector<std::size_t> _position;   //row of every basic column
+};
+
+LinearProgram::LinearProgram(std::size_t numVariables)
+  : _numVariables(numVariables),
+    _cost(numVariables, 0),
+    _lower(numVariables, 0),
+    _upper(numVariables, INFINITE),
+    _solution(numVariables, 0)
+{}
+
+LinearProgram::~LinearProgram() = default;
+
+void LinearProgram::setBounds(std::uint32_t variable, double lower, double upper)
+{
+  _lower[variable] = lower;
+  _upper[variable] = upper;
+}
+
+void LinearProgram::addRow(std::vector<std::pair<std::uint32_t, double>> coefficients, Sense sense, double rhs)
+{
+  _rows.push_back(Row{std::move(coefficients), sense, rhs});
+}
+
+LinearProgram::Status LinearProgram::solve()
+{
+  std::size_t const maxIterations = 100 * (_numVariables + 2 * _rows.size()) + 1000;
+  Status status = Status::IterationLimit;
+  if (_tableau) status = _tableau->resolve(*this, maxIterations);
+
+  //start from scratch the first time, or if the numbers of the old tableau went bad
+  if (status == Status::IterationLimit) {
+    _tableau = std::make_unique<Tableau>(*this);
+    status = _tableau->solve(*this, maxIterations);
+  }
+  if (status != Status::Optimal) return status;
+
+  _objective = 0;
+  for (std::size_t j = 0; j < _numVariables; j++) {
+    _solution[j] = _tableau->value(j);
+    _objective += _cost[j] * _solution[j];
+  }
+  return status;
+}
@@ -0,0 +1,73 @@
+#ifndef LINEAR_PROGRAM_H
+#define LINEAR_PROGRAM_H
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+//Small dense linear program solver for the concatenation of full Steiner trees:
+//  minimize c^T x  subject to  a_i^T x (<=, >= or =) b_i  and  lower <= x <= upper.
+//bounded primal simplex on a full tableau, phase 1 with artificial variables for the rows which are
+//violated by the starting point. Later solves start from the last basis: added rows and changed bounds
+//keep it dual feasible, so the dual simplex restores primal feasibility with a few pivots.
+class LinearProgram
+{
+public:
+  static constexpr double INFINITE = std::numeric_limits<double>::infinity();
+
+  enum class Sense
+  {
+    LessEqual,
+    GreaterEqual,
+    Equal
+  };
+
+  enum class Status
+  {
+    Optimal,
+    Infeasible,
+    IterationLimit
+  };
+
+  //variables start with cost 0 and bounds [0, infinity)
+  explicit LinearProgram(std::size_t numVariables);
+  ~LinearProgram();
+
+  void setCost(std::uint32_t variable, double cost) { _cost[variable] = cost; }
+  void setBounds(std::uint32_t variable, double lower, double upper);
+  double lower(std::uint32_t variable) const { return _lower[variable]; }
+  double upper(std::uint32_t variable) const { return _upper[variable]; }
+
+  void addRow(std::vector<std::pair<std::uint32_t, double>> coefficients, Sense sense, double rhs);
+  std::size_t numRows() const { return _rows.size(); }
+
+  Status solve();
+
+  //of the last solve which returned Optimal
+  double objective() const { return _objective; }
+  double value(std::uint32_t variable) const { return _solution[variable]; }
+
+private:
+  struct Row
+  {
+    std::vector<std::pair<std::uint32_t, double>> coefficients;
+    Sense sense;
+    double rhs;
+  };
+
+  class Tableau;
+  std::unique_ptr<Tableau> _tableau;    //of the last solve, rows added since then are not in it yet
+
+  std::size_t _numVariables;
+  std::vector<double> _cost;
+  std::vector<double> _lower;
+  std::vector<double> _upper;
+  std::vector<Row> _rows;
+
+  double _objective = 0;
+  std::vector<double> _solution;
+};
+
+#endif /*LINEAR_PROGRAM_H */
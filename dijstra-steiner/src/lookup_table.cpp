@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include "lookup_table.h"
+#include "thread_pool.h"
+
+namespace {
+  char constexpr TABLE_MAGIC[8] = {'D', 'S', 'L', 'U', 'T', '0', '0', '1'};
+  std::size_t constexpr TABLE_HEADER_SIZE = sizeof(TABLE_MAGIC) + 2 * sizeof(std::uint32_t);
+
+  using Vector = std::array<std::uint8_t, 2 * (LookupTable::MAX_DEGREE - 1)>;
+
+  std::uint64_t factorial(std::size_t n)
+  {
+    std::uint64_t result = 1;
+    for (std::size_t i = 2; i <= n; i++) result *= i;
+    return result;
+  }
+
+  //rank of a permutation of 0..n-1 in lexicographic order (Lehmer code)
+  std::uint64_t rank(std::uint8_t const* sequence, std::size_t n)
+  {
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i < n; i++) {
+      std::uint64_t smaller = 0;
+      for (std::size_t j = i + 1; j < n; j++) smaller += sequence[j] < sequence[i];
+      result = result * (n - i) + smaller;
+    }
+    return result;
+  }
+
+  bool dominates(Vector const& a, Vector const& b, std::size_t size)
+  {
+    for (std::size_t k = 0; k < size; k++) {
+      if (a[k] > b[k]) return false;
+    }
+    return true;
+  }
+
+  //adds vector to a set of which no vector dominates another, returns false if it is dominated itself
+  bool insertMinimal(std::vector<Vector>& set, Vector const& vector, std::size_t size)
+  {
+    for (Vector const& other : set) {
+      if (dominates(other, vector, size)) return false;
+    }
+    std::erase_if(set, [&](Vector const& other) { return dominates(vector, other, size); });
+    set.push_back(vector);
+    return true;
+  }
+
+  //undominated vectors of the trees for a position sequence with n terminals. terminal i is the vertex
+  //(i, sequence[i]) of the n x n grid, terminal 0 is the root and the subsets I are over 1..n-1
+  std::vector<Vector> wirelengthVectors(std::uint8_t const* sequence, std::size_t n)
+  {
+    std::size_t const size = 2 * (n - 1);
+    std::size_t const numVertices = n * n;
+    std::size_t const numSets = std::size_t(1) << (n - 1);
+    std::vector<std::vector<Vector>> labels(numSets * numVertices);
+
+    for (std::size_t set = 1; set < numSets; set++) {
+      std::vector<Vector>* const at = &labels[set * numVertices];
+      if (std::has_single_bit(set)) {
+        std::size_t const t = std::countr_zero(set) + 1;
+        at[t + sequence[t] * n].push_back(Vector{});
+      } else {
+        //step 7, every split of I into two disjoint non-empty parts once
+        for (std::size_t v = 0; v < numVertices; v++) {
+          for (std::size_t part = (set - 1) & set; part != 0; part = (part - 1) & set) {
+            std::size_t const other = set ^ part;
+            if (part < other) continue;
+            for (Vector const& a : labels[part * numVertices + v]) {
+              for (Vector const& b : labels[other * numVertices + v]) {
+                Vector sum;
+                for (std::size_t k = 0; k < size; k++) sum[k] = a[k] + b[k];
+                insertMinimal(at[v], sum, size);
+              }
+            }
+          }
+        }
+      }
+
+      //step 6, extend along the edges until no vertex gets a new vector
+      std::deque<std::size_t> queue;
+      std::vector<bool> queued(numVertices, false);
+      for (std::size_t v = 0; v < numVertices; v++) {
+        if (!at[v].empty()) {
+          queue.push_back(v);
+          queued[v] = true;
+        }
+      }
+      while (!queue.empty()) {
+        std::size_t const u = queue.front();
+        queue.pop_front();
+        queued[u] = false;
+        std::size_t const column = u % n;
+        std::size_t const row = u / n;
+        auto const extend = [&](std::size_t w, std::size_t gap) {
+          bool changed = false;
+          for (Vector vector : std::vector<Vector>(at[u])) {
+            vector[gap]++;
+            changed |= insertMinimal(at[w], vector, size);
+          }
+          if (changed && !queued[w]) {
+            queue.push_back(w);
+            queued[w] = true;
+          }
+        };
+        if (column != 0) extend(u - 1, column - 1);
+        if (column + 1 != n) extend(u + 1, column);
+        if (row != 0) extend(u - n, n - 1 + row - 1);
+        if (row + 1 != n) extend(u + n, n - 1 + row);
+      }
+    }
+    return labels[(numSets - 1) * numVertices + sequence[0] * n];
+  }
+
+  using Sequence = std::array<std::uint8_t, LookupTable::MAX_DEGREE>;
+
+  //symmetry of the grid: bit 0 reflects x, bit 1 reflects y, bit 2 swaps x and y (in this order).
+  //the position sequence and the wirelength vectors of a tree change alike
+  Sequence transform(Sequence const& sequence, std::size_t n, int symmetry)
+  {
+    Sequence result = sequence;
+    if (symmetry & 1) std::reverse(result.begin(), result.begin() + n);
+    if (symmetry & 2) {
+      for (std::size_t i = 0; i < n; i++) result[i] = std::uint8_t(n - 1 - result[i]);
+    }
+    if (symmetry & 4) {
+      Sequence const swapped = result;
+      for (std::size_t i = 0; i < n; i++) result[swapped[i]] = std::uint8_t(i);
+    }
+    return result;
+  }
+
+  Vector transform(Vector const& vector, std::size_t n, int symmetry)
+  {
+    Vector result = vector;
+    auto const xs = result.begin();
+    auto const ys = result.begin() + (n - 1);
+    if (symmetry & 1) std::reverse(xs, ys);
+    if (symmetry & 2) std::reverse(ys, ys + (n - 1));
+    if (symmetry & 4) std::swap_ranges(xs, ys, ys);
+    return result;
+  }
+
+  template <class T>
+  T readWord(char const* data)
+  {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  template <class T>
+  void writeWord(std::ostream& out, T value)
+  {
+    out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+  }
+}
+
+LookupTable::LookupTable(std::string const& file)
+  : _file(file),
+    _mapped(file)
+{
+  char const* data = _mapped.data();
+  auto const invalid = [this]() { return std::runtime_error("Invalid lookup table: " + _file); };
+  if (_mapped.size() == 0) throw std::runtime_error("Cannot open file: " + _file);
+  if (_mapped.size() < TABLE_HEADER_SIZE || std::memcmp(data, TABLE_MAGIC, sizeof(TABLE_MAGIC)) != 0) throw invalid();
+  _maxDegree = readWord<std::uint32_t>(data + sizeof(TABLE_MAGIC));
+  if (_maxDegree < 2 || _maxDegree > MAX_DEGREE) throw invalid();
+  if (_mapped.size() < TABLE_HEADER_SIZE + 2 * (_maxDegree - 1) * sizeof(std::uint64_t)) throw invalid();
+
+  //the vectors of every sequence have to lie in the file, so a lookup needs no checks
+  _degrees.resize(_maxDegree + 1);
+  for (std::size_t n = 2; n <= _maxDegree; n++) {
+    char const* offsets = data + TABLE_HEADER_SIZE + 2 * (n - 2) * sizeof(std::uint64_t);
+    std::uint64_t const indexOffset = readWord<std::uint64_t>(offsets);
+    std::uint64_t const vectorsOffset = readWord<std::uint64_t>(offsets + sizeof(std::uint64_t));
+    std::uint64_t const numSequences = factorial(n);
+    if (indexOffset % alignof(std::uint32_t) != 0 || indexOffset > _mapped.size()
+        || (_mapped.size() - indexOffset) / sizeof(std::uint32_t) < numSequences + 1 || vectorsOffset > _mapped.size()) {
+      throw invalid();
+    }
+    _degrees[n].index = reinterpret_cast<std::uint32_t const*>(data + indexOffset);
+    _degrees[n].vectors = reinterpret_cast<std::uint8_t const*>(data + vectorsOffset);
+    std::uint32_t const numVectors = _degrees[n].index[numSequences];
+    if ((_mapped.size() - vectorsOffset) / (2 * (n - 1)) < numVectors) throw invalid();
+    for (std::uint64_t r = 0; r < numSequences; r++) {
+      if (_degrees[n].index[r] >= _degrees[n].index[r + 1]) throw invalid();
+    }
+  }
+}
+
+std::optional<Coordinate> LookupTable::length(std::vector<Terminal> const& terminals) const
+{
+  //distinct terminals sorted by x, then y. nets with that many duplicates are left to the search
+  std::array<Terminal, 8 * MAX_DEGREE> points;
+  if (terminals.size() > points.size()) return std::nullopt;
+  std::copy(terminals.begin(), terminals.end(), points.begin());
+  auto const byX = [](Terminal const& a, Terminal const& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); };
+  std::sort(points.begin(), points.begin() + terminals.size(), byX);
+  std::size_t const n = std::unique(points.begin(), points.begin() + terminals.size(),
+                                    [](Terminal const& a, Terminal const& b) { return a.x == b.x && a.y == b.y; }) - points.begin();
+  if (n < 2) return 0;
+  if (n > _maxDegree) return std::nullopt;
+
+  //y ranks, equal y ordered by x rank
+  std::array<std::uint8_t, MAX_DEGREE> byY;
+  std::iota(byY.begin(), byY.begin() + n, std::uint8_t(0));
+  std::sort(byY.begin(), byY.begin() + n, [&points](std::uint8_t a, std::uint8_t b) {
+    return points[a].y < points[b].y || (points[a].y == points[b].y && a < b);
+  });
+  std::array<std::uint8_t, MAX_DEGREE> sequence;
+  for (std::size_t j = 0; j < n; j++) sequence[byY[j]] = std::uint8_t(j);
+
+  std::array<Coordinate, 2 * (MAX_DEGREE - 1)> gaps;
+  for (std::size_t i = 0; i + 1 < n; i++) {
+    gaps[i] = points[i + 1].x - points[i].x;
+    gaps[n - 1 + i] = points[byY[i + 1]].y - points[byY[i]].y;
+  }
+
+  Degree const& degree = _degrees[n];
+  std::uint64_t const r = rank(sequence.data(), n);
+  std::size_t const size = 2 * (n - 1);
+  Coordinate best = std::numeric_limits<Coordinate>::max();
+  for (std::uint32_t i = degree.index[r]; i < degree.index[r + 1]; i++) {
+    std::uint8_t const* vector = degree.vectors + std::size_t(i) * size;
+    Coordinate length = 0;
+    for (std::size_t k = 0; k < size; k++) length += vector[k] * gaps[k];
+    best = std::min(best, length);
+  }
+  return best;
+}
+
+void LookupTable::write(std::string const& file, std::size_t maxDegree, std::size_t threads)
+{
+  if (maxDegree < 2 || maxDegree > MAX_DEGREE) {
+    throw std::runtime_error("The lookup table is for 2 to " + std::to_string(MAX_DEGREE) + " terminals.");
+  }
+  ThreadPool pool(threads);
+
+  //vectors of every degree in the order of the sequence ranks. only the sequences with the smallest rank
+  //among their 8 symmetric ones are solved, the others get the transformed vectors
+  std::vector<std::vector<std::vector<Vector>>> tables(maxDegree + 1);
+  for (std::size_t n = 2; n <= maxDegree; n++) {
+    std::vector<Sequence> canonical;
+    Sequence sequence;
+    std::iota(sequence.begin(), sequence.begin() + n, std::uint8_t(0));
+    std::uint64_t r = 0;
+    do {
+      bool smallest = true;
+      for (int symmetry = 1; symmetry < 8 && smallest; symmetry++) {
+        smallest = rank(transform(sequence, n, symmetry).data(), n) >= r;
+      }
+      if (smallest) canonical.push_back(sequence);
+      r++;
+    } while (std::next_permutation(sequence.begin(), sequence.begin() + n));
+
+    std::vector<std::vector<Vector>> solved(canonical.size());
+    pool.parallel_for(canonical.size(), [&](std::size_t i, std::size_t) {
+      solved[i] = wirelengthVectors(canonical[i].data(), n);
+    });
+
+    tables[n].resize(factorial(n));
+    for (std::size_t i = 0; i < canonical.size(); i++) {
+      for (int symmetry = 0; symmetry < 8; symmetry++) {
+        std::vector<Vector>& vectors = tables[n][rank(transform(canonical[i], n, symmetry).data(), n)];
+        if (!vectors.empty()) continue;   //symmetric sequence, the same vectors
+        for (Vector const& vector : solved[i]) vectors.push_back(transform(vector, n, symmetry));
+        std::sort(vectors.begin(), vectors.end());
+      }
+    }
+  }
+
+  //written next to the old file and renamed over it, like the cache file
+  std::string const temporary = file + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (out.fail()) throw std::runtime_error("Cannot write file: " + temporary);
+    out.write(TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    writeWord<std::uint32_t>(out, std::uint32_t(maxDegree));
+    writeWord<std::uint32_t>(out, 0);
+
+    std::uint64_t offset = TABLE_HEADER_SIZE + 2 * (maxDegree - 1) * sizeof(std::uint64_t);
+    for (std::size_t n = 2; n <= maxDegree; n++) {
+      std::uint64_t numVectors = 0;
+      for (auto const& vectors : tables[n]) numVectors += vectors.size();
+      if (numVectors > std::numeric_limits<std::uint32_t>::max()) throw std::runtime_error("Too many vectors for the lookup table.");
+      writeWord<std::uint64_t>(out, offset);
+      offset += (tables[n].size() + 1) * sizeof(std::uint32_t);
+      writeWord<std::uint64_t>(out, offset);
+      offset += numVectors * 2 * (n - 1);
+      offset = (offset + 3) / 4 * 4;   //the next index is read as uint32
+    }
+
+    for (std::size_t n = 2; n <= maxDegree; n++) {
+      std::uint32_t first = 0;
+      for (auto const& vectors : tables[n]) {
+        writeWord<std::uint32_t>(out, first);
+        first += vectors.size();
+      }
+      writeWord<std::uint32_t>(out, first);
+      std::uint64_t written = 0;
+      for (auto const& vectors : tables[n]) {
+        for (Vector const& vector : vectors) out.write(reinterpret_cast<char const*>(vector.data()), 2 * (n - 1));
+        written += vectors.size() * 2 * (n - 1);
+      }
+      for (; written % 4 != 0; written++) out.put(0);
+    }
+    if (out.fail()) throw std::runtime_error("Cannot write file: " + temporary);
+  }
+  std::filesystem::rename(temporary, file);
+}
@@ -0,0 +1,54 @@
+#ifndef LOOKUP_TABLE_H
+#define LOOKUP_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "mapped_file.h"
+
+//Exact lengths of small nets from a table of potentially optimal wirelength vectors (POWVs), as in FLUTE.
+//Sorted by x, the terminals of a net have a position sequence, the y rank of every terminal. For a fixed
+//sequence every tree in the Hanan grid has the length sum h_i*xgap_i + sum v_j*ygap_j with integer h and v,
+//so the minimum is the smallest dot product of the gaps with the vectors of the trees that are not dominated
+//(componentwise >=) by another one. Those depend only on the sequence and are generated offline, a lookup is
+//then a handful of dot products. Equal coordinates are ranked by the other one and get gap 0.
+//
+//table file, integers in native byte order:
+//  "DSLUT001", uint32 maximal degree D, uint32 0, for every degree d=2..D: uint64 offset of its index, uint64 offset of its vectors
+//  index of degree d: d!+1 uint32, the vectors of the sequence with (lexicographic) rank r are index[r]..index[r+1]-1
+//  vectors of degree d: 2(d-1) uint8 each, the multiplicities of the x gaps followed by those of the y gaps
+class LookupTable
+{
+public:
+  static std::size_t constexpr MAX_DEGREE = 9;
+
+  //maps the table file, throws if it is missing or invalid
+  explicit LookupTable(std::string const& file);
+
+  std::size_t maxDegree() const { return _maxDegree; }
+
+  //length of a minimum Steiner tree, none if the net has more than maxDegree distinct terminals
+  std::optional<Coordinate> length(std::vector<Terminal> const& terminals) const;
+
+  //generates the vectors of all sequences with 2..maxDegree terminals on the given number of threads and writes the file.
+  //they are the labels of the Dijkstra-Steiner recursion with vectors instead of lengths: for every (v,I) the set of
+  //undominated vectors of trees for {v} u I, merged at v (step 7) and extended along the grid edges (step 6)
+  static void write(std::string const& file, std::size_t maxDegree, std::size_t threads);
+
+private:
+  struct Degree
+  {
+    std::uint32_t const* index = nullptr;
+    std::uint8_t const* vectors = nullptr;
+  };
+
+  std::string _file;
+  MappedFile _mapped;
+  std::size_t _maxDegree = 0;
+  std::vector<Degree> _degrees;   //by number of terminals
+};
+
+#endif /*LOOKUP_TABLE_H */
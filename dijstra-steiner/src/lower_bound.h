@@ -0,0 +1,213 @@
+#ifndef LOWER_BOUND_H
+#define LOWER_BOUND_H
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "common.h"
+
+//Feasible lower bounds lb(v,T\I) for the future cost. They are called with I (not T\I) as a
+//bit mask, bit i stands for terminal i and the root t_0 is never in I.
+
+//per-subset tables are allocated up to this many terminals (2^20 entries),
+//larger instances compute what they need from the bits of the subset
+constexpr std::size_t MAX_DENSE_TABLE_TERMINALS = 21;
+
+//bytes of a hash map, every entry is a node with the pair and a pointer to the next one
+template <class Map>
+std::size_t hashMapMemoryUsage(Map const& map)
+{
+  return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + sizeof(void*));
+}
+
+//mask of {t_1,...,t_n-1}
+template <class Mask>
+Mask allTerminalsWithoutFirst(std::size_t numberOfTerminals)
+{
+  std::uint64_t all = numberOfTerminals >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << numberOfTerminals) - 1;
+  return Mask(all & ~std::uint64_t(1));
+}
+
+//lb(v,T\I) = half perimeter of the bounding box of {v} u T\I.
+//the extremes of T\I are precomputed for every I, so evaluating the bound does not allocate
+template <class Mask>
+class BoundingBoxBound
+{
+public:
+  explicit BoundingBoxBound(std::vector<Terminal> const& terminals)
+    : _terminals(terminals),
+      _allTerminalsWithoutFirst(allTerminalsWithoutFirst<Mask>(terminals.size()))
+  {
+    if (terminals.size() > MAX_DENSE_TABLE_TERMINALS) return;
+
+    //S is built from S without its lowest terminal, which was computed before
+    _extremes.resize(std::size_t(1) << (terminals.size() - 1));
+    _extremes[0] = extremesOf(0);
+    for (std::size_t s = 1; s < _extremes.size(); s++) {
+      Extremes const& rest = _extremes[s & (s - 1)];
+      Terminal const& t = terminals[std::countr_zero(s) + 1];
+      _extremes[s] = Extremes{std::min(rest.minX, t.x), std::max(rest.maxX, t.x),
+                              std::min(rest.minY, t.y), std::max(rest.maxY, t.y)};
+    }
+  }
+
+  Coordinate operator()(Terminal const& v, Mask terminalSet) const
+  {
+    Mask remaining = _allTerminalsWithoutFirst & Mask(~terminalSet);
+    Extremes const e = _extremes.empty() ? extremesOf(remaining) : _extremes[remaining >> 1];
+    return std::max(e.maxX, v.x) - std::min(e.minX, v.x) + std::max(e.maxY, v.y) - std::min(e.minY, v.y);
+  }
+
+  //bytes of the table, 16 MB at 21 terminals
+  std::size_t memoryUsage() const { return _extremes.capacity() * sizeof(Extremes); }
+
+private:
+  struct Extremes
+  {
+    Coordinate minX, maxX, minY, maxY;
+  };
+
+  //extremes of {t_0} u S
+  Extremes extremesOf(Mask subset) const
+  {
+    Terminal const& root = _terminals[0];
+    Extremes e{root.x, root.x, root.y, root.y};
+    for (Mask bits = subset; bits != 0; bits &= bits - 1) {
+      Terminal const& t = _terminals[std::countr_zero(bits)];
+      e = Extremes{std::min(e.minX, t.x), std::max(e.maxX, t.x), std::min(e.minY, t.y), std::max(e.maxY, t.y)};
+    }
+    return e;
+  }
+
+  std::vector<Terminal> _terminals;
+  std::vector<Extremes> _extremes;  //extremes of {t_0} u S for all subsets S of {t_1,...,t_n-1}, indexed by S >> 1
+  Mask _allTerminalsWithoutFirst;
+};
+
+//spanning tree bound: in the l1 metric a minimum Steiner tree is at least 2/3 of a minimum spanning tree of
+//its terminals, so mst({v} u T\I) * 2/3 (rounded down) never exceeds smt({v} u T\I). It is not feasible though:
+//moving v along an edge of length c can shorten mst({v} u T\I) by up to c times the degree of v in it, so
+//keys could decrease and a label could be settled too early. The keys therefore stay those of the bounding
+//box, and pruning(v,I) only discards labels which cannot lead to a tree shorter than the upper bound, for
+//which a lower bound that is never too large suffices.
+//mst(T\I) is computed once per subset and kept as a tree, v is then inserted in O(|T\I|)
+template <class Mask>
+class MstBound
+{
+public:
+  explicit MstBound(std::vector<Terminal> const& terminals)
+    : _boundingBox(terminals),
+      _terminals(terminals),
+      _allTerminalsWithoutFirst(allTerminalsWithoutFirst<Mask>(terminals.size()))
+  {
+    if (terminals.size() <= MAX_DENSE_TABLE_TERMINALS) {
+      _first.assign(std::size_t(1) << (terminals.size() - 1), NOT_COMPUTED);
+    }
+  }
+
+  Coordinate operator()(Terminal const& v, Mask terminalSet) const
+  {
+    return _boundingBox(v, terminalSet);
+  }
+
+  Coordinate pruning(Terminal const& v, Mask terminalSet) const
+  {
+    Mask remaining = (_allTerminalsWithoutFirst & Mask(~terminalSet)) | 1;
+    std::size_t const size = std::popcount(remaining);
+    TreeNode const* tree = &_nodes[spanningTree(remaining)];
+
+    //adds v to the tree from the leaves up. for the subtree of a node, length is the minimum spanning tree of
+    //the subtree and v, and longest the longest edge on its path from the node to v. a child is joined to its
+    //parent by the tree edge, which closes a cycle over v; its longest edge is dropped
+    std::int64_t length[MAX_NUM_TERMINALS];
+    Coordinate longest[MAX_NUM_TERMINALS];
+    for (std::size_t i = 0; i < size; i++) {
+      Terminal const& t = _terminals[tree[i].terminal];
+      length[i] = longest[i] = std::abs(t.x - v.x) + std::abs(t.y - v.y);
+    }
+    for (std::size_t child = size; child-- > 1;) {
+      std::size_t const parent = tree[child].parent;
+      Coordinate const edge = tree[child].length;
+      Coordinate const dropped = std::max({edge, longest[child], longest[parent]});
+      length[parent] += length[child] + edge - dropped;
+      if (dropped != edge && dropped != longest[child]) longest[parent] = std::max(edge, longest[child]);
+    }
+    return Coordinate(length[0] * 2 / 3);
+  }
+
+  //bytes of the cached trees and the tables locating them, and of the bounding box table
+  std::size_t memoryUsage() const
+  {
+    return _boundingBox.memoryUsage() + _nodes.capacity() * sizeof(TreeNode) + _first.capacity() * sizeof(std::uint32_t)
+      + hashMapMemoryUsage(_sparseFirst);
+  }
+
+private:
+  //a node of mst(S) in the order prim added them, so the parent comes first
+  struct TreeNode
+  {
+    std::uint8_t terminal;
+    std::uint8_t parent;      //position of the parent in the tree
+    Coordinate length;        //of the edge to the parent
+  };
+
+  static std::uint32_t constexpr NOT_COMPUTED = std::numeric_limits<std::uint32_t>::max();
+
+  //position of mst(subset) in _nodes
+  std::uint32_t spanningTree(Mask subset) const
+  {
+    std::uint32_t& cached = _first.empty() ? _sparseFirst.try_emplace(subset, NOT_COMPUTED).first->second : _first[subset >> 1];
+    if (cached != NOT_COMPUTED) return cached;
+
+    //prim on the complete graph of the subset with l1 distances
+    std::vector<std::uint8_t> terminals;
+    for (Mask bits = subset; bits != 0; bits &= bits - 1) terminals.push_back(std::uint8_t(std::countr_zero(bits)));
+    std::vector<Coordinate> distance(terminals.size(), std::numeric_limits<Coordinate>::max());
+    std::vector<std::uint8_t> closest(terminals.size(), 0);   //position in the tree of the closest tree node
+    std::vector<bool> inTree(terminals.size(), false);
+    cached = std::uint32_t(_nodes.size());
+    std::size_t next = 0;
+    distance[0] = 0;
+    for (std::size_t i = 0; i < terminals.size(); i++) {
+      std::size_t current = next;
+      inTree[current] = true;
+      _nodes.push_back(TreeNode{terminals[current], closest[current], distance[current]});
+      Terminal const& t = _terminals[terminals[current]];
+      Coordinate best = std::numeric_limits<Coordinate>::max();
+      for (std::size_t j = 0; j < terminals.size(); j++) {
+        if (inTree[j]) continue;
+        Terminal const& u = _terminals[terminals[j]];
+        Coordinate d = std::abs(u.x - t.x) + std::abs(u.y - t.y);
+        if (d < distance[j]) {
+          distance[j] = d;
+          closest[j] = std::uint8_t(i);
+        }
+        if (distance[j] < best) {
+          best = distance[j];
+          next = j;
+        }
+      }
+    }
+    return cached;
+  }
+
+  BoundingBoxBound<Mask> _boundingBox;
+  std::vector<Terminal> _terminals;
+  Mask _allTerminalsWithoutFirst;
+  mutable std::vector<TreeNode> _nodes;       //the trees computed so far, one after the other
+  mutable std::vector<std::uint32_t> _first;  //position of mst(T\I) indexed by (T\I without the root) >> 1
+  mutable std::unordered_map<Mask, std::uint32_t> _sparseFirst;  //used instead of _first for large instances
+};
+
+//bounds with a member pruning(v,I) besides the feasible one
+template <class LowerBound, class Mask>
+concept HasPruningBound = requires(LowerBound const& bound, Terminal const& v, Mask terminalSet) {
+  { bound.pruning(v, terminalSet) } -> std::convertible_to<Coordinate>;
+};
+
+#endif /*LOWER_BOUND_H */
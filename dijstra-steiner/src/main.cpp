@@ -1,38 +1,342 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <span>
-#include "parser.h"
+#include <string>
+#include <thread>
+#include "mapped_file.cpp"
+#include "instance_reader.cpp"
 #include "parser.cpp"
+#include "server.cpp"
+#include "hanan_grid.cpp"
+#include "heuristic.cpp"
+#include "reduction.cpp"
+#include "result_cache.cpp"
+#include "lookup_table.cpp"
+#include "thread_pool.cpp"
+#include "linear_program.cpp"
+#include "fst.cpp"
 #include "algorithm.cpp"
+#include "batch.cpp"
+#include "incremental.cpp"
 #include "algorithm.h"
+#include "batch.h"
+#include "incremental.h"
+#include "lookup_table.h"
+#include "parser.h"
+#include "result_cache.h"
+#include "server.h"
 #include "common.h"
 
 void print_usage(std::span<const char*> args)
 {
   std::cout << "Calculates the length of a minimum Steiner Tree for the given "
                "instance file."
-            << "Usage: " << args[0] << " file" << std::endl;
+            << "Usage: " << args[0] << " [options] file\n"
+            << "       " << args[0] << " [options] file|directory...   (batch mode, one CSV line per instance)\n"
+            << "       " << args[0] << " [options] --server|--socket <path>   (server mode, length-prefixed requests, see README)\n"
+            << "Options:\n"
+            << "  --engine <e>     Exact algorithm, auto (default), ds (Dijkstra-Steiner) or fst (full Steiner tree concatenation)\n"
+            << "  --queue <q>      Priority queue for the labels, heap (4-ary heap, default) or radix\n"
+            << "  --lb <b>         Lower bound for the future cost, bb (bounding box, default) or mst (bounding box, and\n"
+            << "                   pruning with a minimum spanning tree)\n"
+            << "  --mem-limit <m>  Stop with an error if the search needs more than m MB (m >= 1)\n"
+            << "  --time-limit <s> Stop after s > 0 seconds and print the best tree found and a lower bound\n"
+            << "  --threads <n>    Expand the labels of Dijkstra-Steiner on n threads (at most one per core), 0 for one\n"
+            << "                   per core (default 1)\n"
+            << "  --jobs <n>       Batch and server mode: solve n instances at the same time (at most one per core),\n"
+            << "                   0 for one per core (default)\n"
+            << "  --server         Answer the requests on stdin on stdout until stdin is closed\n"
+            << "  --socket <path>  Answer the requests of the connections to a Unix domain socket at path\n"
+            << "  --no-reduce      Search the whole Hanan grid, without reductions and splitting at cut terminals\n"
+            << "  --cache          Solve instances of the same shape (up to translation, symmetry and coordinate gaps) once\n"
+            << "  --cache-file <f> Also look up and store the lengths in the file f, implies --cache\n"
+            << "  --cache-size <n> Entries kept in memory by the cache, at least 1 (default 1000000)\n"
+            << "  --eco <edits>    Solve the instance, then apply the edits of the file (lines \"+ x y\" to add and \"- x y\" to\n"
+            << "                   remove a terminal) one by one, reusing the labels, and print the length after each\n"
+            << "  --table <f>      Look up nets with few terminals in the table file f (written by bench --write-table)\n"
+            << "  --write-binary <f> Write the instance to f in the binary format, which is read without parsing\n"
+            << "  --stats          Print the counters of the search as JSON to stderr\n"
+            << "  --verbose        Print the number of settled labels, the reductions and the running time to stderr" << std::endl;
+}
+
+//a number of the command line, digits only. false for signs, trailing characters and values above max
+bool parse_count(std::string const& text, std::size_t max, std::size_t& value)
+{
+  auto const [last, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  return error == std::errc() && last == text.data() + text.size() && value <= max;
+}
+
+//a positive number of seconds of the command line, false for anything else
+bool parse_seconds(std::string const& text, double& seconds)
+{
+  auto const [last, error] = std::from_chars(text.data(), text.data() + text.size(), seconds);
+  return error == std::errc() && last == text.data() + text.size() && std::isfinite(seconds) && seconds > 0;
+}
+
+//"cache_lookups": l, "cache_hits": h, "cache_hit_rate": h/l
+std::string cache_stats(ResultCache const& cache)
+{
+  std::size_t const lookups = cache.lookups();
+  std::size_t const hits = cache.hits();
+  return "\"cache_lookups\": " + std::to_string(lookups) + ", \"cache_hits\": " + std::to_string(hits)
+    + ", \"cache_hit_rate\": " + std::to_string(lookups == 0 ? 0.0 : double(hits) / double(lookups));
+}
+
+//counters of the search as one JSON object, the label counters stay 0 if the full Steiner tree engine was used
+//or the length came from the cache
+void print_stats(std::ostream& out, Algorithm::Result const& result, double seconds, ResultCache const* cache)
+{
+  Algorithm::Statistics const& stats = result.stats;
+  out << "{\"length\": " << result.length << ", \"optimal\": " << (result.optimal ? "true" : "false")
+      << ", \"time\": " << seconds
+      << ", \"full_steiner_trees\": " << result.fullSteinerTrees << ", \"branch_nodes\": " << result.branchNodes
+      << ", \"labels_pushed\": " << stats.labelsPushed << ", \"labels_popped\": " << stats.labelsPopped
+      << ", \"labels_relaxed\": " << stats.labelsRelaxed << ", \"labels_merged\": " << stats.labelsMerged
+      << ", \"labels_stored\": " << stats.labelsStored << ", \"peak_queue_size\": " << stats.peakQueueSize
+      << ", \"peak_permanent_labels\": " << stats.peakPermanentLabels
+      << ", \"lower_bound_time\": " << stats.lowerBoundSeconds << ", \"settled_by_size\": [";
+  for (std::size_t k = 0; k < stats.settledBySize.size(); k++) out << (k == 0 ? "" : ", ") << stats.settledBySize[k];
+  out << "]";
+  if (cache != nullptr) out << ", " << cache_stats(*cache);
+  out << "}" << std::endl;
+}
+
+//answer to a request of the server mode, the lines that are printed for an instance file
+std::string answer(Server::Request const& request, Algorithm::Options const& options)
+{
+  auto const result = Algorithm::solve(Parser::terminals(request.points), options);
+  std::string answer = std::to_string(result.length) + "\n";
+  if (not result.optimal) answer += "lower bound: " + std::to_string(result.lowerBound) + "\n";
+  return answer;
+}
+
+//solves the terminals and then the net after every edit of the file, one length per line and
+//a "lower bound: <b>" line after it if the time limit was hit, as for an instance file
+void run_eco(std::vector<Terminal> const& terminals, Algorithm::Options const& options, std::string const& editsFile, bool verbose)
+{
+  std::ifstream edits(editsFile);
+  if (edits.fail()) throw std::runtime_error("Cannot open file: " + editsFile);
+
+  IncrementalSteiner net(terminals, options);
+  auto const print = [&net, verbose](Algorithm::Result const& result, double seconds) {
+    std::cout << result.length << std::endl;
+    if (not result.optimal) std::cout << "lower bound: " << result.lowerBound << std::endl;
+    if (verbose) {
+      std::cerr << "terminals: " << net.terminals().size() << ", labels settled: " << result.labelsSettled
+                << ", time: " << seconds << " s" << std::endl;
+    }
+  };
+  auto const timed = [&net]() {
+    auto const start = std::chrono::steady_clock::now();
+    Algorithm::Result const result = net.solve();
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    return std::make_pair(result, elapsed.count());
+  };
+
+  auto const [result, seconds] = timed();
+  print(result, seconds);
+  std::string op;
+  Terminal t;
+  while (edits >> op >> t.x >> t.y) {
+    if (op == "+") net.add_terminal(t);
+    else if (op == "-") net.remove_terminal(t);
+    else throw std::runtime_error("Invalid edit: " + op);
+    auto const [result, seconds] = timed();
+    print(result, seconds);
+  }
+  if (!edits.eof()) throw std::runtime_error("Invalid edits file: " + editsFile);
 }
 
 int main(int argc, char const* argv[])
 {
   auto const args = std::span(argv, argc);
-  if (argc != 2) {
+  std::size_t const cores = std::max(1u, std::thread::hardware_concurrency());
+  Algorithm::Options options;
+  bool verbose = false;
+  std::size_t jobs = cores;
+  bool useCache = false;
+  std::string cacheFile;
+  std::size_t cacheSize = 1000000;
+  std::string editsFile;
+  std::string tableFile;
+  std::string binaryFile;
+  bool server = false;
+  std::string socketPath;
+  std::vector<std::string> paths;
+
+  for (std::size_t i = 1; i < args.size(); i++) {
+    std::string const arg = args[i];
+    if (arg == "--engine" && i + 1 < args.size()) {
+      std::string const engine = args[++i];
+      if (engine == "auto") {
+        options.engine = Algorithm::Engine::Auto;
+      } else if (engine == "ds") {
+        options.engine = Algorithm::Engine::DijkstraSteiner;
+      } else if (engine == "fst") {
+        options.engine = Algorithm::Engine::Fst;
+      } else {
+        print_usage(args);
+        return 1;
+      }
+    } else if (arg == "--queue" && i + 1 < args.size()) {
+      std::string const queue = args[++i];
+      if (queue == "heap") {
+        options.queue = Algorithm::QueueType::DaryHeap;
+      } else if (queue == "radix") {
+        options.queue = Algorithm::QueueType::RadixQueue;
+      } else {
+        print_usage(args);
+        return 1;
+      }
+    } else if (arg == "--lb" && i + 1 < args.size()) {
+      std::string const bound = args[++i];
+      if (bound == "bb") {
+        options.lowerBound = Algorithm::LowerBoundType::BoundingBox;
+      } else if (bound == "mst") {
+        options.lowerBound = Algorithm::LowerBoundType::Mst;
+      } else {
+        print_usage(args);
+        return 1;
+      }
+    } else if (arg == "--mem-limit" && i + 1 < args.size()) {
+      //in MB, so that the bytes still fit, and 0 would mean no limit
+      std::size_t megabytes = 0;
+      if (!parse_count(args[++i], std::numeric_limits<std::size_t>::max() >> 20, megabytes) || megabytes == 0) {
+        print_usage(args);
+        return 1;
+      }
+      options.memoryLimit = megabytes << 20;
+    } else if (arg == "--time-limit" && i + 1 < args.size()) {
+      if (!parse_seconds(args[++i], options.timeLimit)) {
+        print_usage(args);
+        return 1;
+      }
+    } else if (arg == "--threads" && i + 1 < args.size()) {
+      if (!parse_count(args[++i], std::numeric_limits<std::size_t>::max(), options.threads)) {
+        print_usage(args);
+        return 1;
+      }
+      //more threads than cores only take turns
+      options.threads = options.threads == 0 ? cores : std::min(options.threads, cores);
+    } else if (arg == "--jobs" && i + 1 < args.size()) {
+      if (!parse_count(args[++i], std::numeric_limits<std::size_t>::max(), jobs)) {
+        print_usage(args);
+        return 1;
+      }
+      jobs = jobs == 0 ? cores : std::min(jobs, cores);
+    } else if (arg == "--no-reduce") {
+      options.reduce = false;
+    } else if (arg == "--cache") {
+      useCache = true;
+    } else if (arg == "--cache-file" && i + 1 < args.size()) {
+      useCache = true;
+      cacheFile = args[++i];
+    } else if (arg == "--cache-size" && i + 1 < args.size()) {
+      if (!parse_count(args[++i], std::numeric_limits<std::size_t>::max(), cacheSize) || cacheSize == 0) {
+        print_usage(args);
+        return 1;
+      }
+    } else if (arg == "--eco" && i + 1 < args.size()) {
+      editsFile = args[++i];
+    } else if (arg == "--table" && i + 1 < args.size()) {
+      tableFile = args[++i];
+    } else if (arg == "--server") {
+      server = true;
+    } else if (arg == "--socket" && i + 1 < args.size()) {
+      socketPath = args[++i];
+    } else if (arg == "--write-binary" && i + 1 < args.size()) {
+      binaryFile = args[++i];
+    } else if (arg == "--stats") {
+      options.stats = true;
+    } else if (arg == "--verbose") {
+      verbose = true;
+    } else if (not arg.starts_with("--")) {
+      paths.push_back(arg);
+    } else {
+      print_usage(args);
+      return 1;
+    }
+  }
+  bool const serverMode = server || !socketPath.empty();
+  if (paths.empty() != serverMode) {
     print_usage(args);
     return 1;
   }
+
   try {
-    std::ifstream input_file(args[1]);
-    if (input_file.bad() or input_file.fail()) {
-      throw std::runtime_error("Cannot open file: " + std::string(args[1]));
+    std::unique_ptr<ResultCache> cache;
+    if (useCache) {
+      cache = std::make_unique<ResultCache>(cacheSize, cacheFile);
+      options.cache = cache.get();
+    }
+    std::unique_ptr<LookupTable> table;
+    if (!tableFile.empty()) {
+      table = std::make_unique<LookupTable>(tableFile);
+      options.table = table.get();
     }
-    auto const terminals = Parser::parse_instance(input_file);
 
-    if (terminals.size() > MAX_NUM_TERMINALS) {
-      throw std::runtime_error("Cannot handle instances with more than 20 terminals.");
+    //the cache and the lookup table stay warm over all requests
+    if (serverMode) {
+      auto const handler = [&options](Server::Request const& request, std::size_t) { return answer(request, options); };
+      if (!socketPath.empty()) Server::serve_socket(socketPath, jobs, handler);
+      else Server::serve(0, 1, jobs, handler);
+      if (cache) cache->save();   //also after SIGINT or SIGTERM, which end the serving
+      return EXIT_SUCCESS;
     }
 
-    std::cout << Algorithm::dijkstra_steiner(terminals) << std::endl;
+    //several files or a directory, an instance that fails only gets an error in its line
+    if (paths.size() > 1 || std::filesystem::is_directory(paths[0])) {
+      auto const files = Batch::instance_files(paths);
+      std::size_t const failed = Batch::run(files, options, jobs, std::cout);
+      if (cache) {
+        cache->save();
+        if (options.stats) std::cerr << "{" << cache_stats(*cache) << "}" << std::endl;
+      }
+      return failed == 0 ? EXIT_SUCCESS : 1;
+    }
+
+    auto const terminals = Parser::read_instance(paths[0]);
+    if (!binaryFile.empty()) {
+      Parser::write_binary(binaryFile, terminals);
+      return EXIT_SUCCESS;
+    }
+
+    if (!editsFile.empty()) {
+      run_eco(terminals, options, editsFile, verbose);
+      return EXIT_SUCCESS;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const result = Algorithm::solve(terminals, options);
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << result.length << std::endl;
+    if (not result.optimal) {
+      std::cout << "lower bound: " << result.lowerBound << std::endl;
+    }
+    if (options.stats) {
+      print_stats(std::cerr, result, elapsed.count(), cache.get());
+    }
+    if (verbose) {
+      if (result.fromTable) {
+        std::cerr << "looked up in the table, time: " << elapsed.count() << " s" << std::endl;
+      } else if (result.fullSteinerTrees != 0) {
+        std::cerr << "full Steiner trees: " << result.fullSteinerTrees << ", branch and bound nodes: " << result.branchNodes
+                  << ", time: " << elapsed.count() << " s" << std::endl;
+      } else {
+        std::size_t const removed = result.gridVertices > result.searchedVertices ? result.gridVertices - result.searchedVertices : 0;
+        std::cerr << "grid vertices: " << result.gridVertices << ", removed: " << removed << ", parts: " << result.parts << std::endl;
+        std::cerr << "labels settled: " << result.labelsSettled << ", time: " << elapsed.count() << " s" << std::endl;
+      }
+    }
+    if (cache) cache->save();
 
   } catch (std::exception const& e) {
     std::cout << "Exception occurred: " << e.what() << std::endl;
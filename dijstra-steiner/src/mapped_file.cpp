@@ -0,0 +1,53 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.h"
+
+MappedFile::MappedFile(std::string const& path)
+{
+  int const fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno == ENOENT) return;
+    throw std::runtime_error("Cannot open file: " + path + " (" + std::strerror(errno) + ")");
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot read file: " + path);
+  }
+  _size = std::size_t(status.st_size);
+  if (_size != 0) {
+    void* address = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Cannot map file: " + path + " (" + std::strerror(errno) + ")");
+    }
+    _data = static_cast<char const*>(address);
+  }
+  ::close(fd);   //the mapping stays valid
+}
+
+MappedFile::~MappedFile()
+{
+  if (_data != nullptr) ::munmap(const_cast<char*>(_data), _size);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : _data(std::exchange(other._data, nullptr)),
+    _size(std::exchange(other._size, 0))
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this != &other) {
+    if (_data != nullptr) ::munmap(const_cast<char*>(_data), _size);
+    _data = std::exchange(other._data, nullptr);
+    _size = std::exchange(other._size, 0);
+  }
+  return *this;
+}
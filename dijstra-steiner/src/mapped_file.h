@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+//read-only memory mapping of a whole file, the pages are loaded on first access.
+//a file that does not exist maps to an empty view, other errors throw
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  explicit MappedFile(std::string const& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  char const* data() const { return _data; }
+  std::size_t size() const { return _size; }
+  std::string_view view() const { return std::string_view(_data, _size); }
+
+private:
+  char const* _data = nullptr;
+  std::size_t _size = 0;
+};
+
+#endif /*MAPPED_FILE_H */
@@ -1,13 +1,22 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <string>
 #include <vector>
-#include <iostream>
 #include "common.h"
+#include "instance_reader.h"
 
 namespace Parser {
 
-std::vector<Terminal> parse_instance(std::istream& input);
+//the number of terminals, then one "x y" per line, or a binary instance (see instance_reader.h).
+//throws on malformed input
+std::vector<Terminal> parse_instance(std::string_view data);
+std::vector<Terminal> read_instance(std::string const& file);
+
+std::vector<Terminal> terminals(InstanceReader::Points const& points);
+
+//the terminals as a binary instance
+void write_binary(std::string const& file, std::vector<Terminal> const& terminals);
 
 }
 
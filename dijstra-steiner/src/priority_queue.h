@@ -0,0 +1,196 @@
+#ifndef PRIORITY_QUEUE_H
+#define PRIORITY_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "common.h"
+#include "label_index.h"
+
+//Priority queues over label ids keyed by l(v,I)+lb(v,T\I). Both share the interface
+//  push(id, key)  inserts the label or lowers its key if it is already queued
+//  pop()          removes and returns a label with minimum key
+//  minKey()       minimum key of all queued labels
+//  hasKey(key)    whether a label with the given key is queued, key must be the minimum key popped last
+//  empty(), size(), memoryUsage()
+//so dijkstra_steiner can be instantiated with either of them.
+
+//indexed d-ary heap with decrease-key, positions of the queued labels are stored by id
+template <int D>
+class DaryHeap
+{
+public:
+  bool empty() const { return _heap.empty(); }
+  std::size_t size() const { return _heap.size(); }
+  Coordinate minKey() const { return _heap[0].key; }
+  bool hasKey(Coordinate key) const { return !_heap.empty() && _heap[0].key == key; }
+  std::size_t memoryUsage() const { return _heap.capacity() * sizeof(Entry) + _position.capacity() * sizeof(std::uint32_t); }
+
+  void push(LabelId id, Coordinate key)
+  {
+    if (id >= _position.size()) _position.resize(id + 1, NOT_QUEUED);
+    std::size_t pos = _position[id];
+    if (pos == NOT_QUEUED) {
+      _heap.push_back(Entry{key, id});
+      siftUp(_heap.size() - 1);
+    }
+    else if (key < _heap[pos].key) {  //decrease-key
+      _heap[pos].key = key;
+      siftUp(pos);
+    }
+  }
+
+  LabelId pop()
+  {
+    LabelId top = _heap[0].id;
+    _position[top] = NOT_QUEUED;
+    Entry last = _heap.back();
+    _heap.pop_back();
+    if (!_heap.empty()) {
+      _heap[0] = last;
+      siftDown(0);
+    }
+    return top;
+  }
+
+private:
+  struct Entry
+  {
+    Coordinate key;
+    LabelId id;
+  };
+  static constexpr std::uint32_t NOT_QUEUED = std::numeric_limits<std::uint32_t>::max();
+
+  void siftUp(std::size_t pos)
+  {
+    Entry entry = _heap[pos];
+    while (pos > 0) {
+      std::size_t parent = (pos - 1) / D;
+      if (_heap[parent].key <= entry.key) break;
+      _heap[pos] = _heap[parent];
+      _position[_heap[pos].id] = pos;
+      pos = parent;
+    }
+    _heap[pos] = entry;
+    _position[entry.id] = pos;
+  }
+
+  void siftDown(std::size_t pos)
+  {
+    Entry entry = _heap[pos];
+    while (true) {
+      std::size_t first = D * pos + 1;
+      if (first >= _heap.size()) break;
+      std::size_t last = std::min(first + D, _heap.size());
+      std::size_t best = first;
+      for (std::size_t child = first + 1; child < last; child++) {
+        if (_heap[child].key < _heap[best].key) best = child;
+      }
+      if (entry.key <= _heap[best].key) break;
+      _heap[pos] = _heap[best];
+      _position[_heap[pos].id] = pos;
+      pos = best;
+    }
+    _heap[pos] = entry;
+    _position[entry.id] = pos;
+  }
+
+  std::vector<Entry> _heap;
+  std::vector<std::uint32_t> _position;   //index in _heap by label id
+};
+
+//monotone radix heap: keys pushed must not be smaller than the last popped key, which holds
+//since lb is feasible. a decrease-key pushes a second entry, outdated entries are skipped on pop
+class RadixQueue
+{
+public:
+  bool empty() const { return _size == 0; }
+  std::size_t size() const { return _size; }
+
+  std::size_t memoryUsage() const
+  {
+    std::size_t bytes = _key.capacity() * sizeof(Coordinate);
+    for (auto const& bucket : _buckets) bytes += bucket.capacity() * sizeof(Entry);
+    return bytes;
+  }
+
+  Coordinate minKey()
+  {
+    refill();
+    return _last;
+  }
+
+  //unlike minKey this never moves on to a larger key, so keys from key on can still be pushed afterwards
+  bool hasKey(Coordinate key)
+  {
+    while (!_buckets[0].empty() && outdated(_buckets[0].back())) _buckets[0].pop_back();
+    return key == _last && !_buckets[0].empty();
+  }
+
+  void push(LabelId id, Coordinate key)
+  {
+    if (id >= _key.size()) _key.resize(id + 1, NOT_QUEUED);
+    if (_key[id] == NOT_QUEUED) _size++;
+    else if (key >= _key[id]) return;
+    _key[id] = key;
+    _buckets[bucketOf(key)].push_back(Entry{key, id});
+  }
+
+  LabelId pop()
+  {
+    refill();
+    LabelId id = _buckets[0].back().id;
+    _buckets[0].pop_back();
+    _key[id] = NOT_QUEUED;
+    _size--;
+    return id;
+  }
+
+private:
+  struct Entry
+  {
+    Coordinate key;
+    LabelId id;
+  };
+  static constexpr Coordinate NOT_QUEUED = std::numeric_limits<Coordinate>::max();
+
+  //entries in bucket i differ from _last first in bit i-1 (counted from the least significant bit)
+  std::size_t bucketOf(Coordinate key) const
+  {
+    return std::bit_width(static_cast<std::uint32_t>(key ^ _last));
+  }
+
+  bool outdated(Entry const& entry) const { return _key[entry.id] != entry.key; }
+
+  //makes sure bucket 0 holds a queued label with the minimum key
+  void refill()
+  {
+    while (!_buckets[0].empty() && outdated(_buckets[0].back())) _buckets[0].pop_back();
+    if (!_buckets[0].empty()) return;
+
+    std::size_t i = 1;
+    while (true) {
+      auto& bucket = _buckets[i];
+      std::erase_if(bucket, [this](Entry const& entry) { return outdated(entry); });
+      if (!bucket.empty()) break;
+      i++;
+    }
+
+    //redistribute the first non-empty bucket, all of its entries move to lower buckets
+    Coordinate newLast = _buckets[i][0].key;
+    for (Entry const& entry : _buckets[i]) newLast = std::min(newLast, entry.key);
+    _last = newLast;
+    for (Entry const& entry : _buckets[i]) _buckets[bucketOf(entry.key)].push_back(entry);
+    _buckets[i].clear();
+  }
+
+  std::array<std::vector<Entry>, 33> _buckets;
+  std::vector<Coordinate> _key;   //current key by label id, NOT_QUEUED if not in the queue
+  Coordinate _last = 0;
+  std::size_t _size = 0;
+};
+
+#endif /*PRIORITY_QUEUE_H */
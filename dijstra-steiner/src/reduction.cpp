@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "reduction.h"
+
+namespace Reduction {
+
+namespace {
+  auto constexpr NONE = std::uint32_t(-1);
+
+  //neighbours of v in the grid in the order left, right, down, up, NONE at the border
+  std::array<std::uint32_t, 4> neighbours(HananGrid const& grid, std::uint32_t v)
+  {
+    std::size_t column = grid.column(v);
+    std::size_t row = grid.row(v);
+    return {column != 0 ? v - 1 : NONE,
+            column + 1 != grid.numColumns() ? v + 1 : NONE,
+            row != 0 ? v - std::uint32_t(grid.numColumns()) : NONE,
+            row + 1 != grid.numRows() ? v + std::uint32_t(grid.numColumns()) : NONE};
+  }
+
+  std::vector<std::uint8_t> terminalVertices(HananGrid const& grid, std::vector<Terminal> const& terminals)
+  {
+    std::vector<std::uint8_t> isTerminal(grid.numVertices(), 0);
+    for (Terminal const& t : terminals) isTerminal[grid.vertexOf(t)] = 1;
+    return isTerminal;
+  }
+}
+
+std::vector<std::uint8_t> removed_vertices(HananGrid const& grid, std::vector<Terminal> const& terminals)
+{
+  std::vector<std::uint8_t> removed(grid.numVertices(), 0);
+  std::vector<std::uint8_t> const isTerminal = terminalVertices(grid, terminals);
+
+  //a vertex has to be checked again whenever one of its neighbours is removed
+  std::vector<std::uint32_t> stack;
+  for (std::uint32_t v = 0; v < grid.numVertices(); v++) {
+    if (!isTerminal[v]) stack.push_back(v);
+  }
+
+  while (!stack.empty()) {
+    std::uint32_t v = stack.back();
+    stack.pop_back();
+    if (removed[v] || isTerminal[v]) continue;
+
+    auto const adjacent = neighbours(grid, v);
+    std::uint32_t horizontal = NONE;
+    std::uint32_t vertical = NONE;
+    int degree = 0;
+    for (int i = 0; i < 4; i++) {
+      if (adjacent[i] == NONE || removed[adjacent[i]]) continue;
+      degree++;
+      (i < 2 ? horizontal : vertical) = adjacent[i];
+    }
+
+    if (degree == 2) {
+      //a corner needs one edge of each direction, the opposite corner is in the column of the one and the row of the other
+      if (horizontal == NONE || vertical == NONE) continue;
+      std::uint32_t opposite = horizontal + vertical - v;
+      if (removed[opposite]) continue;
+    }
+    else if (degree > 2) continue;
+
+    removed[v] = 1;
+    for (std::uint32_t w : adjacent) {
+      if (w != NONE && !removed[w]) stack.push_back(w);
+    }
+  }
+  return removed;
+}
+
+std::vector<std::vector<Terminal>> split_at_cut_terminal(HananGrid const& grid, std::vector<Terminal> const& terminals,
+                                                         std::vector<std::uint8_t> const& removed)
+{
+  //component of every vertex in the grid without the cut vertex, found by depth first search
+  std::vector<std::uint32_t> component(grid.numVertices());
+  std::vector<std::uint32_t> stack;
+
+  for (Terminal const& t : terminals) {
+    std::uint32_t const cut = grid.vertexOf(t);
+    std::fill(component.begin(), component.end(), NONE);
+    std::uint32_t numComponents = 0;
+
+    for (Terminal const& s : terminals) {
+      std::uint32_t const start = grid.vertexOf(s);
+      if (start == cut || component[start] != NONE) continue;
+      component[start] = numComponents;
+      stack.push_back(start);
+      while (!stack.empty()) {
+        std::uint32_t v = stack.back();
+        stack.pop_back();
+        for (std::uint32_t w : neighbours(grid, v)) {
+          if (w == NONE || w == cut || removed[w] || component[w] != NONE) continue;
+          component[w] = numComponents;
+          stack.push_back(w);
+        }
+      }
+      numComponents++;
+    }
+    if (numComponents < 2) continue;
+
+    //terminals at the cut vertex itself go into every part
+    std::vector<std::vector<Terminal>> parts(numComponents);
+    for (Terminal const& s : terminals) {
+      std::uint32_t const vertex = grid.vertexOf(s);
+      if (vertex != cut) {
+        parts[component[vertex]].push_back(s);
+        continue;
+      }
+      for (auto& part : parts) part.push_back(s);
+    }
+    return parts;
+  }
+  return {};
+}
+
+}
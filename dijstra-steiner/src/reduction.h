@@ -0,0 +1,27 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include <cstdint>
+#include <vector>
+#include "common.h"
+#include "hanan_grid.h"
+
+//Reductions of the Hanan grid before the search. Every step keeps at least one minimum Steiner tree
+//of the terminals in the remaining graph, so the search on the reduced grid is still exact.
+namespace Reduction {
+
+//marks the vertices which can be removed from the grid, 1 = removed. Repeatedly removes non-terminal vertices
+//  - of degree at most 1, a minimum tree never ends in a Steiner point
+//  - of degree 2 with one horizontal and one vertical edge (an empty corner) if the opposite corner of
+//    the rectangle is still in the grid, a tree through the corner can be rerouted over the opposite one
+std::vector<std::uint8_t> removed_vertices(HananGrid const& grid, std::vector<Terminal> const& terminals);
+
+//if a terminal t is a cut vertex of the reduced grid, every minimum Steiner tree is the union of minimum trees
+//of the parts on either side of t. Returns the terminal sets of the parts (each with t, in the original order),
+//or no parts if there is no such terminal
+std::vector<std::vector<Terminal>> split_at_cut_terminal(HananGrid const& grid, std::vector<Terminal> const& terminals,
+                                                         std::vector<std::uint8_t> const& removed);
+
+}
+
+#endif /*REDUCTION_H */
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include "result_cache.h"
+
+namespace {
+  char constexpr MAGIC[8] = {'D', 'S', 'C', 'A', 'C', 'H', 'E', '1'};
+  std::size_t constexpr HEADER_SIZE = sizeof(MAGIC) + sizeof(std::uint64_t);
+  std::size_t constexpr ENTRY_HEADER_SIZE = sizeof(std::uint32_t) + sizeof(std::int32_t);
+
+  //order of the keys in the file: shorter keys first, then lexicographic
+  bool keyLess(ResultCache::Key const& a, ResultCache::Key const& b)
+  {
+    if (a.size() != b.size()) return a.size() < b.size();
+    return a < b;
+  }
+
+  template <class T>
+  T load(char const* data)
+  {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  template <class T>
+  void store(std::ostream& out, T value)
+  {
+    out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+  }
+}
+
+ResultCache::Key ResultCache::key(std::vector<Terminal> const& terminals)
+{
+  Key best;
+  std::vector<Terminal> points(terminals.size());
+  std::vector<Coordinate> xs, ys;
+  std::vector<std::pair<std::int32_t, std::int32_t>> ranks;
+
+  for (int symmetry = 0; symmetry < 8; symmetry++) {
+    for (std::size_t i = 0; i < terminals.size(); i++) {
+      Terminal p = terminals[i];
+      if (symmetry & 4) std::swap(p.x, p.y);
+      if (symmetry & 1) p.x = -p.x;
+      if (symmetry & 2) p.y = -p.y;
+      points[i] = p;
+    }
+
+    xs.clear();
+    ys.clear();
+    for (Terminal const& p : points) {
+      xs.push_back(p.x);
+      ys.push_back(p.y);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+    ranks.clear();
+    for (Terminal const& p : points) {
+      ranks.emplace_back(std::lower_bound(xs.begin(), xs.end(), p.x) - xs.begin(),
+                         std::lower_bound(ys.begin(), ys.end(), p.y) - ys.begin());
+    }
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+
+    Key key{std::int32_t(xs.size()), std::int32_t(ys.size())};
+    for (std::size_t i = 1; i < xs.size(); i++) key.push_back(xs[i] - xs[i - 1]);
+    for (std::size_t i = 1; i < ys.size(); i++) key.push_back(ys[i] - ys[i - 1]);
+    for (auto const& [x, y] : ranks) {
+      key.push_back(x);
+      key.push_back(y);
+    }
+    if (symmetry == 0 || keyLess(key, best)) best = std::move(key);
+  }
+  return best;
+}
+
+std::size_t ResultCache::KeyHash::operator()(Key const& key) const
+{
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  for (std::int32_t word : key) hash = (hash ^ std::uint32_t(word)) * 0x100000001b3ull;
+  return std::size_t(hash);
+}
+
+ResultCache::ResultCache(std::size_t capacity, std::string file)
+  : _capacity(std::max<std::size_t>(capacity, 1)),
+    _file(std::move(file))
+{
+  if (_file.empty()) return;
+  _mapped = MappedFile(_file);
+  if (_mapped.size() == 0) return;
+
+  //the index has to fit into the file, the entries are checked when they are read
+  if (_mapped.size() < HEADER_SIZE || std::memcmp(_mapped.data(), MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error("Invalid cache file: " + _file);
+  }
+  _numDiskEntries = load<std::uint64_t>(_mapped.data() + sizeof(MAGIC));
+  if (_numDiskEntries > (_mapped.size() - HEADER_SIZE) / sizeof(std::uint64_t)) {
+    throw std::runtime_error("Invalid cache file: " + _file);
+  }
+}
+
+std::optional<Coordinate> ResultCache::findOnDisk(Key const& key) const
+{
+  char const* data = _mapped.data();
+  auto const entryKey = [this, data](std::uint64_t i) {
+    std::uint64_t const offset = load<std::uint64_t>(data + HEADER_SIZE + i * sizeof(std::uint64_t));
+    if (offset > _mapped.size() - ENTRY_HEADER_SIZE) throw std::runtime_error("Invalid cache file: " + _file);
+    std::uint32_t const size = load<std::uint32_t>(data + offset);
+    if (size > (_mapped.size() - offset - ENTRY_HEADER_SIZE) / sizeof(std::int32_t)) {
+      throw std::runtime_error("Invalid cache file: " + _file);
+    }
+    Key words(size);
+    if (size != 0) std::memcpy(words.data(), data + offset + ENTRY_HEADER_SIZE, size * sizeof(std::int32_t));
+    return std::make_pair(std::move(words), load<std::int32_t>(data + offset + sizeof(std::uint32_t)));
+  };
+
+  std::uint64_t low = 0;
+  std::uint64_t high = _numDiskEntries;
+  while (low < high) {
+    std::uint64_t const middle = low + (high - low) / 2;
+    auto const [words, length] = entryKey(middle);
+    if (keyLess(words, key)) low = middle + 1;
+    else if (keyLess(key, words)) high = middle;
+    else return length;
+  }
+  return std::nullopt;
+}
+
+void ResultCache::remember(Key const& key, Coordinate length)
+{
+  auto const it = _byKey.find(key);
+  if (it != _byKey.end()) {
+    _recent.splice(_recent.begin(), _recent, it->second);
+    return;
+  }
+  _recent.emplace_front(key, length);
+  _byKey.emplace(key, _recent.begin());
+  if (_recent.size() > _capacity) {
+    _byKey.erase(_recent.back().first);
+    _recent.pop_back();
+  }
+}
+
+std::optional<Coordinate> ResultCache::find(Key const& key)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _lookups++;
+  auto const it = _byKey.find(key);
+  if (it != _byKey.end()) {
+    _hits++;
+    _recent.splice(_recent.begin(), _recent, it->second);
+    return it->second->second;
+  }
+  std::optional<Coordinate> const length = findOnDisk(key);
+  if (length) {
+    _hits++;
+    remember(key, *length);
+  }
+  return length;
+}
+
+void ResultCache::insert(Key const& key, Coordinate length)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_byKey.count(key) != 0) return;
+  remember(key, length);
+  if (!_file.empty()) _inserted.emplace_back(key, length);
+}
+
+void ResultCache::save() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_file.empty() || _inserted.empty()) return;
+
+  std::map<Key, Coordinate, bool (*)(Key const&, Key const&)> entries(keyLess);
+  char const* data = _mapped.data();
+  for (std::uint64_t i = 0; i < _numDiskEntries; i++) {
+    std::uint64_t const offset = load<std::uint64_t>(data + HEADER_SIZE + i * sizeof(std::uint64_t));
+    std::uint32_t const size = load<std::uint32_t>(data + offset);
+    Key words(size);
+    if (size != 0) std::memcpy(words.data(), data + offset + ENTRY_HEADER_SIZE, size * sizeof(std::int32_t));
+    entries.emplace(std::move(words), load<std::int32_t>(data + offset + sizeof(std::uint32_t)));
+  }
+  for (auto const& [key, length] : _inserted) entries.emplace(key, length);
+
+  //written next to the old file and renamed over it, so readers never see a partial file
+  std::string const temporary = _file + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (out.fail()) throw std::runtime_error("Cannot write file: " + temporary);
+    out.write(MAGIC, sizeof(MAGIC));
+    store<std::uint64_t>(out, entries.size());
+    std::uint64_t offset = HEADER_SIZE + entries.size() * sizeof(std::uint64_t);
+    for (auto const& [key, length] : entries) {
+      store<std::uint64_t>(out, offset);
+      offset += ENTRY_HEADER_SIZE + key.size() * sizeof(std::int32_t);
+    }
+    for (auto const& [key, length] : entries) {
+      store<std::uint32_t>(out, std::uint32_t(key.size()));
+      store<std::int32_t>(out, length);
+      out.write(reinterpret_cast<char const*>(key.data()), key.size() * sizeof(std::int32_t));
+    }
+    if (out.fail()) throw std::runtime_error("Cannot write file: " + temporary);
+  }
+  std::filesystem::rename(temporary, _file);
+}
+
+std::size_t ResultCache::lookups() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _lookups;
+}
+
+std::size_t ResultCache::hits() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _hits;
+}
@@ -0,0 +1,69 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common.h"
+#include "mapped_file.h"
+
+//Lengths of solved instances by the canonical form of their terminal set, so nets of the same shape are
+//solved once. Recently used entries are kept in memory (LRU), a cache file is memory mapped and searched
+//in place, entries solved in this run are added to it by save(). All methods may be called from several threads.
+//
+//cache file, integers in native byte order:
+//  "DSCACHE1", uint64 number of entries, uint64 offset of every entry (sorted by key),
+//  entries: uint32 number of key words, int32 length, int32 key words
+class ResultCache
+{
+public:
+  using Key = std::vector<std::int32_t>;
+
+  //canonical form of a terminal set: the terminals are rank compressed to their Hanan grid lines, the key
+  //holds the number of lines, the gaps between them and the sorted ranks of the distinct terminals. it
+  //determines the instance up to translation, so it is exact. of the 8 rectilinear symmetries (reflections
+  //and the swap of x and y) the one with the smallest key is taken
+  static Key key(std::vector<Terminal> const& terminals);
+
+  //capacity is the number of entries kept in memory, the file is mapped if it exists
+  explicit ResultCache(std::size_t capacity, std::string file = "");
+
+  std::optional<Coordinate> find(Key const& key);
+  void insert(Key const& key, Coordinate length);
+
+  //writes the cache file with the entries of the old one and those inserted since, does nothing without a file
+  void save() const;
+
+  std::size_t lookups() const;
+  std::size_t hits() const;
+
+private:
+  struct KeyHash
+  {
+    std::size_t operator()(Key const& key) const;
+  };
+  using Entries = std::list<std::pair<Key, Coordinate>>;   //most recently used first
+
+  std::optional<Coordinate> findOnDisk(Key const& key) const;
+  void remember(Key const& key, Coordinate length);
+
+  mutable std::mutex _mutex;
+  std::size_t _capacity;
+  Entries _recent;
+  std::unordered_map<Key, Entries::iterator, KeyHash> _byKey;
+
+  std::string _file;
+  MappedFile _mapped;
+  std::uint64_t _numDiskEntries = 0;
+  std::vector<std::pair<Key, Coordinate>> _inserted;    //to be added to the file
+
+  std::size_t _lookups = 0;
+  std::size_t _hits = 0;
+};
+
+#endif /*RESULT_CACHE_H */
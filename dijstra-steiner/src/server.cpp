@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.h"
+
+namespace Server {
+
+namespace {
+  std::size_t constexpr READ_BUFFER_SIZE = std::size_t(1) << 16;
+  std::uint32_t constexpr MAX_REQUEST_SIZE = std::uint32_t(1) << 30;
+  std::size_t constexpr REQUESTS_PER_THREAD = 4;   //requests in flight per worker, bounds the memory
+
+  //SIGINT and SIGTERM write to this pipe, it is never read so every wait below sees it
+  int stopPipe[2] = {-1, -1};
+
+  void onStopSignal(int)
+  {
+    int const savedErrno = errno;
+    [[maybe_unused]] ssize_t const written = ::write(stopPipe[1], "", 1);
+    errno = savedErrno;
+  }
+
+  //once per process, a second signal ends the process as without the handler
+  void stopOnSignals()
+  {
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+      if (::pipe(stopPipe) != 0) return;
+      for (int fd : stopPipe) ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+      ::fcntl(stopPipe[1], F_SETFL, O_NONBLOCK);
+      struct sigaction action{};
+      action.sa_handler = onStopSignal;
+      action.sa_flags = SA_RESTART | SA_RESETHAND;
+      sigemptyset(&action.sa_mask);
+      ::sigaction(SIGINT, &action, nullptr);
+      ::sigaction(SIGTERM, &action, nullptr);
+    });
+  }
+
+  //waits until fd can be read, false if a stop signal came first
+  bool waitReadable(int fd)
+  {
+    pollfd fds[2] = {{fd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+    while (true) {
+      int const count = ::poll(fds, 2, -1);
+      if (count < 0 && errno == EINTR) continue;
+      if (count < 0) throw std::runtime_error(std::string("Cannot wait for input: ") + std::strerror(errno));
+      if (fds[1].revents != 0) return false;
+      return true;
+    }
+  }
+
+  //reads from a file descriptor through a buffer, so small records do not cost a system call each
+  class Reader
+  {
+  public:
+    explicit Reader(int fd) : _fd(fd), _buffer(READ_BUFFER_SIZE) {}
+
+    //false if the input ended before the first byte, throws if it ended within
+    bool read(void* data, std::size_t size)
+    {
+      char* out = static_cast<char*>(data);
+      std::size_t done = 0;
+      while (done < size) {
+        if (_begin == _end && !fill()) {
+          if (done == 0) return false;
+          throw std::runtime_error("Request is truncated.");
+        }
+        std::size_t const part = std::min(size - done, _end - _begin);
+        std::memcpy(out + done, _buffer.data() + _begin, part);
+        _begin += part;
+        done += part;
+      }
+      return true;
+    }
+
+  private:
+    //a stop signal ends the input like the end of the file
+    bool fill()
+    {
+      if (!waitReadable(_fd)) return false;
+      while (true) {
+        ssize_t const count = ::read(_fd, _buffer.data(), _buffer.size());
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) throw std::runtime_error(std::string("Cannot read request: ") + std::strerror(errno));
+        _begin = 0;
+        _end = std::size_t(count);
+        return count > 0;
+      }
+    }
+
+    int _fd;
+    std::vector<char> _buffer;
+    std::size_t _begin = 0;
+    std::size_t _end = 0;
+  };
+
+  void writeAll(int fd, std::string const& data)
+  {
+    std::size_t done = 0;
+    while (done < data.size()) {
+      ssize_t const count = ::write(fd, data.data() + done, data.size() - done);
+      if (count < 0 && errno == EINTR) continue;
+      if (count < 0) throw std::runtime_error(std::string("Cannot write response: ") + std::strerror(errno));
+      done += std::size_t(count);
+    }
+  }
+
+  void appendResponse(std::string& out, std::string const& answer)
+  {
+    std::uint32_t const size = answer.size();
+    out.append(reinterpret_cast<char const*>(&size), sizeof(size));
+    out += answer;
+  }
+}
+
+void serve(int in, int out, std::size_t threads, Handler const& handler)
+{
+  stopOnSignals();
+  threads = std::max<std::size_t>(threads, 1);
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::pair<std::uint64_t, Request>> pending;   //read but not taken by a worker
+  std::map<std::uint64_t, std::string> answers;             //solved but not written
+  std::uint64_t numRead = 0;
+  std::uint64_t numWritten = 0;
+  bool ended = false;
+  bool failed = false;   //the writer could not write, the rest is only read
+
+  std::vector<std::thread> workers;
+  for (std::size_t thread = 0; thread < threads; thread++) {
+    workers.emplace_back([&, thread]() {
+      while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]() { return !pending.empty() || ended; });
+        if (pending.empty()) return;
+        auto [number, request] = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+
+        std::string answer;
+        try {
+          answer = handler(request, thread);
+        } catch (std::exception const& e) {
+          answer = std::string("Exception occurred: ") + e.what() + "\n";
+        }
+        lock.lock();
+        answers.emplace(number, std::move(answer));
+        changed.notify_all();
+      }
+    });
+  }
+
+  //consecutive answers are written with one system call
+  std::thread writer([&]() {
+    std::string buffer;
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&]() { return answers.count(numWritten) != 0 || (ended && numWritten == numRead); });
+      if (answers.count(numWritten) == 0) return;
+      buffer.clear();
+      for (auto it = answers.begin(); it != answers.end() && it->first == numWritten; it = answers.erase(it)) {
+        appendResponse(buffer, it->second);
+        numWritten++;
+      }
+      changed.notify_all();
+      lock.unlock();
+      try {
+        writeAll(out, buffer);
+      } catch (std::exception const&) {
+        lock.lock();
+        failed = true;
+        changed.notify_all();
+        return;
+      }
+    }
+  });
+
+  auto const finish = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ended = true;
+    }
+    changed.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    writer.join();
+  };
+
+  try {
+    Reader reader(in);
+    std::uint32_t size = 0;
+    std::vector<char> record;
+    while (reader.read(&size, sizeof(size))) {
+      if (size > MAX_REQUEST_SIZE) throw std::runtime_error("Request of " + std::to_string(size) + " bytes is too large.");
+      record.resize(size);
+      if (!reader.read(record.data(), size)) throw std::runtime_error("Request is truncated.");
+
+      Request request;
+      std::uint32_t n = 0;
+      if (size >= 2 * sizeof(std::uint32_t)) std::memcpy(&n, record.data() + sizeof(std::uint32_t), sizeof(n));
+      bool const valid = size >= 2 * sizeof(std::uint32_t)
+        && size - 2 * sizeof(std::uint32_t) == 2 * std::uint64_t(n) * sizeof(std::int32_t);
+      if (valid) {
+        std::memcpy(&request.what, record.data(), sizeof(request.what));
+        char const* values = record.data() + 2 * sizeof(std::uint32_t);
+        request.points.x.resize(n);
+        request.points.y.resize(n);
+        if (n != 0) {
+          std::memcpy(request.points.x.data(), values, n * sizeof(std::int32_t));
+          std::memcpy(request.points.y.data(), values + n * sizeof(std::int32_t), n * sizeof(std::int32_t));
+        }
+      }
+
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&]() { return numRead - numWritten < REQUESTS_PER_THREAD * threads || failed; });
+      if (failed) break;
+      if (valid) pending.emplace_back(numRead, std::move(request));
+      else answers.emplace(numRead, "Malformed request\n");
+      numRead++;
+      changed.notify_all();
+    }
+  } catch (...) {
+    finish();
+    throw;
+  }
+  finish();
+}
+
+void serve_socket(std::string const& path, std::size_t threads, Handler const& handler)
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path is too long: " + path);
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  std::signal(SIGPIPE, SIG_IGN);   //a client that goes away makes write fail instead of ending the process
+  stopOnSignals();
+  int const listening = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listening < 0) throw std::runtime_error(std::string("Cannot create socket: ") + std::strerror(errno));
+  ::unlink(path.c_str());
+  if (::bind(listening, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 || ::listen(listening, 16) != 0) {
+    ::close(listening);
+    throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(errno));
+  }
+
+  while (true) {
+    if (!waitReadable(listening)) {
+      ::close(listening);
+      ::unlink(path.c_str());
+      return;
+    }
+    int const connection = ::accept(listening, nullptr, nullptr);
+    if (connection < 0) {
+      if (errno == EINTR) continue;
+      ::close(listening);
+      throw std::runtime_error(std::string("Cannot accept connection: ") + std::strerror(errno));
+    }
+    //a broken connection only ends itself
+    try {
+      serve(connection, connection, threads, handler);
+    } catch (std::exception const&) {
+    }
+    ::close(connection);
+  }
+}
+
+}
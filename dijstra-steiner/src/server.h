@@ -0,0 +1,42 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "instance_reader.h"
+
+//Long-running mode shared by dijkstra-steiner and netlengths: nets come as length-prefixed records on a
+//file descriptor (stdin or a connection of a Unix domain socket), are solved on worker threads and the
+//answers are written in the order of the requests. A client may send further requests before it read the
+//answers of the earlier ones.
+//
+//records, integers in native byte order:
+//  request:  uint32 size of the rest, uint32 what (which answers, up to the tool), uint32 n, n int32 x, n int32 y
+//  response: uint32 size of the rest, the answer as text
+namespace Server {
+
+struct Request
+{
+  std::uint32_t what = 0;
+  InstanceReader::Points points;
+};
+
+//answer to one request, called on several threads at the same time. thread is in [0, threads) and no two
+//calls with the same thread run at the same time, so buffers can be kept per thread
+using Handler = std::function<std::string(Request const& request, std::size_t thread)>;
+
+//serves the requests read from in until it is closed or the process gets SIGINT or SIGTERM, up to threads of
+//them are solved at the same time. the requests read before are still answered, a second signal ends the
+//process. a malformed request gets the answer "Malformed request" if its size is plausible, otherwise this throws
+void serve(int in, int out, std::size_t threads, Handler const& handler);
+
+//listens on a Unix domain socket at path (replacing a stale socket file) and serves the connections one
+//after the other as above, until SIGINT or SIGTERM. then the current connection is answered up to the last
+//request read, the socket file is removed and this returns
+void serve_socket(std::string const& path, std::size_t threads, Handler const& handler);
+
+}
+
+#endif /*SERVER_H */
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include "thread_pool.h"
+
+namespace {
+  //long loops are taken in chunks of at most this size, so threads which finish early help with the rest
+  std::size_t constexpr MAX_CHUNK_SIZE = 16;
+}
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+{
+  for (std::size_t thread = 1; thread < numThreads; thread++) {
+    _workers.emplace_back([this, thread] { work(thread); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _started.notify_all();
+  for (std::thread& worker : _workers) worker.join();
+}
+
+void ThreadPool::parallel_for(std::size_t n, std::function<void(std::size_t, std::size_t)> const& task)
+{
+  if (_workers.empty() || n <= SERIAL_SIZE) {
+    for (std::size_t i = 0; i < n; i++) task(i, 0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _task = &task;
+    _size = n;
+    _chunk = std::min((n + size() - 1) / size(), MAX_CHUNK_SIZE);
+    _next = 0;
+    _busy = _workers.size();
+    _generation++;
+  }
+  _started.notify_all();
+  runIterations(0);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _finished.wait(lock, [this] { return _busy == 0; });
+  _task = nullptr;
+}
+
+void ThreadPool::work(std::size_t thread)
+{
+  std::size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _started.wait(lock, [this, seen] { return _stop || _generation != seen; });
+      if (_stop) return;
+      seen = _generation;
+    }
+    runIterations(thread);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _busy--;
+    }
+    _finished.notify_one();
+  }
+}
+
+void ThreadPool::runIterations(std::size_t thread)
+{
+  while (true) {
+    std::size_t const begin = _next.fetch_add(_chunk, std::memory_order_relaxed);
+    if (begin >= _size) return;
+    std::size_t const end = std::min(begin + _chunk, _size);
+    for (std::size_t i = begin; i < end; i++) (*_task)(i, thread);
+  }
+}
+
+void run_work_stealing(std::size_t numThreads, std::size_t n, std::function<void(std::size_t)> const& task)
+{
+  numThreads = std::max<std::size_t>(1, std::min(numThreads, n));
+  struct Deque
+  {
+    std::mutex mutex;
+    std::deque<std::size_t> tasks;
+  };
+  std::vector<Deque> deques(numThreads);
+  for (std::size_t i = 0; i < n; i++) deques[i % numThreads].tasks.push_back(i);
+
+  auto const work = [&](std::size_t thread) {
+    while (true) {
+      std::size_t next = n;
+      {
+        Deque& own = deques[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+          next = own.tasks.front();
+          own.tasks.pop_front();
+        }
+      }
+      //steal the task another thread would do last
+      for (std::size_t offset = 1; next == n && offset < numThreads; offset++) {
+        Deque& victim = deques[(thread + offset) % numThreads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+          next = victim.tasks.back();
+          victim.tasks.pop_back();
+        }
+      }
+      //tasks are never added, so all deques being empty means the work is done
+      if (next == n) return;
+      task(next);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (std::size_t thread = 1; thread < numThreads; thread++) workers.emplace_back(work, thread);
+  work(0);
+  for (std::thread& worker : workers) worker.join();
+}
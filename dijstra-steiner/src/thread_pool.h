@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//fixed set of worker threads which run the iterations of a loop together with the calling thread.
+//the threads are kept between the loops, so short loops do not pay for starting threads
+class ThreadPool
+{
+public:
+  //numThreads counts the calling thread, so numThreads - 1 workers are started
+  explicit ThreadPool(std::size_t numThreads);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  std::size_t size() const { return _workers.size() + 1; }
+
+  //loops with at most this many iterations run on the calling thread, waking the workers costs more
+  static std::size_t constexpr SERIAL_SIZE = 2;
+
+  //calls task(i, thread) for every i in [0, n) and returns when all calls are done. thread is in
+  //[0, size()) and no two calls with the same thread run at the same time. the iterations are split into
+  //chunks of n / size() (at most 16), so even short loops are spread over all threads
+  void parallel_for(std::size_t n, std::function<void(std::size_t, std::size_t)> const& task);
+
+private:
+  void work(std::size_t thread);
+  void runIterations(std::size_t thread);
+
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _started;
+  std::condition_variable _finished;
+  std::size_t _generation = 0;      //counts the loops, a change wakes the workers
+  std::size_t _busy = 0;            //workers still in the current loop
+  bool _stop = false;
+
+  std::function<void(std::size_t, std::size_t)> const* _task = nullptr;
+  std::size_t _size = 0;
+  std::size_t _chunk = 1;           //iterations taken at once from the shared counter
+  std::atomic<std::size_t> _next = 0;
+};
+
+//runs task(i) for every i in [0, n) on numThreads threads, the calling thread included, and returns when
+//all are done. the tasks are dealt round robin in index order, so earlier tasks start first. every thread
+//works through its own deque from the front and steals from the back of another one when it runs dry
+void run_work_stealing(std::size_t numThreads, std::size_t n, std::function<void(std::size_t)> const& task);
+
+#endif /*THREAD_POOL_H */
@@ -4,25 +4,22 @@
 #include <limits>
 #include <vector>
 #include <list>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <tuple>
 #include "common.h"
 // #include <iostream>
 
 
 // Computes BB for the given coordinates in O(n) time
-int boundingBox(const std::vector<Coordinate>& coords) {
-    if (coords.empty()) return 0;
+int boundingBox(const std::vector<int>& x_coords, const std::vector<int>& y_coords) {
+    if (x_coords.empty() or y_coords.empty()) return 0;
 
-    int minX = std::numeric_limits<int>::max();
-    int maxX = std::numeric_limits<int>::min();
-    int minY = std::numeric_limits<int>::max();
-    int maxY = std::numeric_limits<int>::min();
-
-    for (const auto& coord : coords) {
-        minX = std::min(minX, coord.first);
-        maxX = std::max(maxX, coord.first);
-        minY = std::min(minY, coord.second);
-        maxY = std::max(maxY, coord.second);
-    }
+    int minX, maxX, minY, maxY;
+    Kernels::min_max(x_coords.data(), x_coords.size(), minX, maxX);
+    Kernels::min_max(y_coords.data(), y_coords.size(), minY, maxY);
 
     return maxX - minX + maxY - minY;
 }
@@ -86,11 +83,8 @@ int star(const std::vector<int>& x_coords, const std::vector<int>& y_coords) {
     int median_y = sorted_y[sorted_y.size() / 2];
 
     // Calculate the sum of distances to the median in linear time
-    int total_distance = 0;
-    for (size_t i = 0; i < x_coords.size(); ++i) {
-        total_distance += std::abs(x_coords[i] - median_x) + std::abs(y_coords[i] - median_y);
-    }
-    return total_distance;
+    return Kernels::abs_distance_sum(x_coords.data(), x_coords.size(), median_x)
+        + Kernels::abs_distance_sum(y_coords.data(), y_coords.size(), median_y);
 }
 
 // Computes the minimum spanning tree length in O(n^2) time
@@ -139,61 +133,141 @@ int mst_alt(const std::vector<int>& x_coords, const std::vector<int>& y_coords)
 }
 
 
-// Computes the minimum spanning tree length in O(n^2) time, uses lists and deletion instead of vectors
+// Computes the minimum spanning tree length in O(n^2) time, the vertices not in the tree are kept in aligned
+// x, y and weight arrays; an added vertex is replaced by the last one, so the arrays stay dense for the kernel
 int mst(const std::vector<Coordinate>& coords) { // Turned out to be faster than the previous version
     if (coords.empty()) return 0;
 
     // Use something based on prim's algorithm to find the minimum spanning tree
-    
-    size_t size = coords.size();
-    std::vector<int> weights(size, std::numeric_limits<int>::max());
-    std::list<std::pair<Coordinate, int>> weighted_vertices; // list of pairs (vertex, weight)
 
-    for (size_t i = 1; i < size; ++i) {
-        weighted_vertices.emplace_back(coords[i], weights[i]);
+    size_t size = coords.size() - 1; // vertices not in the tree
+    Kernels::AlignedInts x_coords(size);
+    Kernels::AlignedInts y_coords(size);
+    Kernels::AlignedInts weights(size, std::numeric_limits<int>::max());
+    for (size_t i = 0; i < size; ++i) {
+        x_coords[i] = coords[i + 1].first;
+        y_coords[i] = coords[i + 1].second;
     }
 
     int total_length = 0;
     Coordinate min_vertex = coords[0]; // the first vertex is the starting point
 
     // Two nested loops, both ranging over the set of vertices, so O(n^2) runtime
-    while(!weighted_vertices.empty()) {
-        
+    while (size > 0) {
+
         // Reduce weights and find the vertex with the smallest distance
-        int min_weight = std::numeric_limits<int>::max();
-        auto min_it = weighted_vertices.end();
+        size_t min_index = Kernels::prim_update(x_coords.data(), y_coords.data(), weights.data(), size, min_vertex.first, min_vertex.second);
 
-        for (auto it = weighted_vertices.begin(); it != weighted_vertices.end(); ++it) {
-            auto& [vertex, weight] = *it;
-            
-            // Reduce weights
-            int distance = abs(vertex.first - min_vertex.first) + abs(vertex.second - min_vertex.second);
-            if(weight > distance) weight = distance;
-            
-            // Select as next min
-            if (weight < min_weight) {
-                min_weight = weight;
-                min_it = it; // update the iterator to the minimum vertex
+        total_length += weights[min_index];
+        min_vertex = Coordinate(x_coords[min_index], y_coords[min_index]);
+
+        // Move the last vertex into its place
+        --size;
+        x_coords[min_index] = x_coords[size];
+        y_coords[min_index] = y_coords[size];
+        weights[min_index] = weights[size];
+
+    }
+
+    return total_length;
+
+}
+
+
+typedef std::tuple<long, size_t, size_t> WeightedEdge; // (length, i, j)
+
+// Candidate edges of a rectilinear MST in O(n log n) time. In each of the 8 octants around a point only the
+// nearest other point can be its MST neighbour (Guibas-Stolfi, Zhou et al.), so a sweep finds at most 4n
+// candidate edges, one octant per pass over 4 reflections
+std::vector<WeightedEdge> octant_edges(const std::vector<Coordinate>& coords) {
+    size_t size = coords.size();
+    std::vector<std::pair<long, long>> points(coords.begin(), coords.end()); // long, as the reflections negate
+    std::vector<WeightedEdge> edges;
+    edges.reserve(4 * size);
+    std::vector<size_t> order(size);
+    std::iota(order.begin(), order.end(), 0);
+
+    for (int pass = 0; pass < 4; ++pass) {
+        // Sweep by x + y, the map holds the points without a neighbour yet in their octant, keyed by -y.
+        // A point i is that neighbour for the active points j with y_j <= y_i and x_i - y_i >= x_j - y_j
+        std::sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+            return points[i].first + points[i].second < points[j].first + points[j].second;
+        });
+        std::map<long, size_t> active;
+        for (size_t i : order) {
+            for (auto it = active.lower_bound(-points[i].second); it != active.end(); it = active.erase(it)) {
+                size_t j = it->second;
+                long dx = points[i].first - points[j].first;
+                long dy = points[i].second - points[j].second;
+                if (dy > dx) break;
+                edges.emplace_back(dx + dy, i, j);
             }
+            active[-points[i].second] = i;
         }
+        for (auto& point : points) {
+            if (pass & 1) point.first = -point.first;
+            else std::swap(point.first, point.second);
+        }
+    }
+    return edges;
+}
 
-        total_length += min_weight;
+// Edges of a minimum spanning tree of the points 0..size-1 among the given edges, Kruskal with union-find
+// (union by size, path halving)
+std::vector<WeightedEdge> kruskal(size_t size, std::vector<WeightedEdge> edges) {
+    std::sort(edges.begin(), edges.end());
+    std::vector<size_t> parent(size);
+    std::vector<size_t> component_size(size, 1);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](size_t v) {
+        while (parent[v] != v) v = parent[v] = parent[parent[v]];
+        return v;
+    };
+
+    std::vector<WeightedEdge> tree;
+    tree.reserve(size > 0 ? size - 1 : 0);
+    for (const auto& edge : edges) {
+        size_t a = find(std::get<1>(edge));
+        size_t b = find(std::get<2>(edge));
+        if (a == b) continue;
+        if (component_size[a] < component_size[b]) std::swap(a, b);
+        parent[b] = a;
+        component_size[a] += component_size[b];
+        tree.push_back(edge);
+        if (tree.size() == size - 1) break;
+    }
+    return tree;
+}
 
-        // Remove the vertex with the minimum weight from the list
-        
-        min_vertex = min_it->first; // update the minimum vertex
-        weighted_vertices.erase(min_it);
+// Edges of a minimum spanning tree in O(n log n) time
+std::vector<WeightedEdge> rmst_edges(const std::vector<Coordinate>& coords) {
+    return kruskal(coords.size(), octant_edges(coords));
+}
 
-    }
-    
-    return total_length;
+// Computes the minimum spanning tree length in O(n log n) time
+int mst_sweep(const std::vector<Coordinate>& coords) {
+    if (coords.size() < 2) return 0;
 
+    long total_length = 0;
+    for (const auto& edge : rmst_edges(coords)) total_length += std::get<0>(edge);
+    return static_cast<int>(total_length);
 }
 
+// Below this many points the O(n^2) Prim of mst is faster than the sweep (measured on random points), with
+// the AVX2 kernel up to about ten times as many
+const size_t MST_SWEEP_MIN_SIZE = 1000;
+const size_t MST_SWEEP_MIN_SIZE_AVX2 = 8000;
 
+// Computes the minimum spanning tree length with the faster of mst and mst_sweep for the size
+int mst_length(const std::vector<Coordinate>& coords) {
+    size_t min_size = Kernels::uses_avx2() ? MST_SWEEP_MIN_SIZE_AVX2 : MST_SWEEP_MIN_SIZE;
+    return coords.size() < min_size ? mst(coords) : mst_sweep(coords);
+}
 
-// Computes an approximate for the minimal steiner tree length in O(n^3) time
-int steiner_approx(const std::vector<Coordinate>& coordinates) {
+
+// Computes an approximate for the minimal steiner tree length in O(n^3) time (kept for comparison, steiner_approx
+// below builds the same tree)
+int steiner_approx_slow(const std::vector<Coordinate>& coordinates) {
     if (coordinates.size() < 2) return 0;
 
     //std::list<Coordinate> graph_vertices; //actually not needed, we only need the edges
@@ -306,4 +380,638 @@ int steiner_approx(const std::vector<Coordinate>& coordinates) {
         //          << edge.second.first << ", " << edge.second.second << ")\n";
     }
     return total_distance;
-}
\ No newline at end of file
+}
+
+// Distance from c to the bounding box (shortest path area) of the edge (u, w)
+inline int distance_to_box(const Coordinate& c, const Coordinate& u, const Coordinate& w) {
+    int dist = 0;
+    if (c.first < std::min(u.first, w.first)) dist = std::min(u.first, w.first) - c.first;
+    else if (c.first > std::max(u.first, w.first)) dist = c.first - std::max(u.first, w.first);
+    if (c.second < std::min(u.second, w.second)) dist += std::min(u.second, w.second) - c.second;
+    else if (c.second > std::max(u.second, w.second)) dist += c.second - std::max(u.second, w.second);
+    return dist;
+}
+
+// Uniform grid over the bounding box of the terminals, an edge is listed in every cell its box overlaps.
+// Removed edges are dropped from a cell when it is visited
+struct EdgeGrid {
+    int min_x = 0;
+    int min_y = 0;
+    long cell_width = 1;
+    long cell_height = 1;
+    int columns = 1;
+    int rows = 1;
+    std::vector<std::vector<size_t>> cells;
+
+    explicit EdgeGrid(const std::vector<Coordinate>& coordinates) {
+        int max_x = coordinates[0].first;
+        int max_y = coordinates[0].second;
+        min_x = max_x;
+        min_y = max_y;
+        for (const auto& c : coordinates) {
+            min_x = std::min(min_x, c.first);
+            max_x = std::max(max_x, c.first);
+            min_y = std::min(min_y, c.second);
+            max_y = std::max(max_y, c.second);
+        }
+        // About one cell per terminal
+        long side = std::max(1L, static_cast<long>(std::sqrt(static_cast<double>(coordinates.size()))));
+        cell_width = (static_cast<long>(max_x) - min_x) / side + 1;
+        cell_height = (static_cast<long>(max_y) - min_y) / side + 1;
+        columns = static_cast<int>((static_cast<long>(max_x) - min_x) / cell_width + 1);
+        rows = static_cast<int>((static_cast<long>(max_y) - min_y) / cell_height + 1);
+        cells.resize(static_cast<size_t>(columns) * rows);
+    }
+
+    int column(int x) const { return static_cast<int>((static_cast<long>(x) - min_x) / cell_width); }
+    int row(int y) const { return static_cast<int>((static_cast<long>(y) - min_y) / cell_height); }
+
+    void insert(size_t edge, const Coordinate& u, const Coordinate& w) {
+        for (int r = row(std::min(u.second, w.second)); r <= row(std::max(u.second, w.second)); ++r) {
+            for (int c = column(std::min(u.first, w.first)); c <= column(std::max(u.first, w.first)); ++c) {
+                cells[static_cast<size_t>(r) * columns + c].push_back(edge);
+            }
+        }
+    }
+};
+
+// kd-tree over the terminals that are not in the Steiner tree yet. A node keeps an upper bound of the keys
+// (distances to the tree) below it, so an edge only visits the nodes with terminals it may be closer to
+struct TerminalTree {
+    struct Node {
+        int min_x, max_x, min_y, max_y;
+        int max_key;
+        size_t begin, end; // range in order
+        size_t left, right; // children, 0 for a leaf
+        size_t parent;
+    };
+    static const size_t LEAF_SIZE = 8;
+
+    std::vector<size_t> order;
+    std::vector<Node> nodes;
+    std::vector<size_t> leaf; // leaf node of every terminal
+
+    TerminalTree(const std::vector<Coordinate>& coordinates, std::vector<size_t> terminals, const std::vector<int>& keys)
+        : order(std::move(terminals)), leaf(coordinates.size(), 0) {
+        if (!order.empty()) build(coordinates, keys, 0, order.size(), 0);
+    }
+
+    size_t build(const std::vector<Coordinate>& coordinates, const std::vector<int>& keys, size_t begin, size_t end, size_t parent) {
+        size_t index = nodes.size();
+        nodes.push_back(Node{std::numeric_limits<int>::max(), std::numeric_limits<int>::min(),
+            std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), -1, begin, end, 0, 0, parent});
+        for (size_t i = begin; i < end; ++i) {
+            const Coordinate& c = coordinates[order[i]];
+            nodes[index].min_x = std::min(nodes[index].min_x, c.first);
+            nodes[index].max_x = std::max(nodes[index].max_x, c.first);
+            nodes[index].min_y = std::min(nodes[index].min_y, c.second);
+            nodes[index].max_y = std::max(nodes[index].max_y, c.second);
+            nodes[index].max_key = std::max(nodes[index].max_key, keys[order[i]]);
+        }
+        if (end - begin <= LEAF_SIZE) {
+            for (size_t i = begin; i < end; ++i) leaf[order[i]] = index;
+            return index;
+        }
+
+        // Split at the median of the longer side
+        bool by_x = static_cast<long>(nodes[index].max_x) - nodes[index].min_x
+            >= static_cast<long>(nodes[index].max_y) - nodes[index].min_y;
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](size_t a, size_t b) {
+            return by_x ? coordinates[a].first < coordinates[b].first : coordinates[a].second < coordinates[b].second;
+        });
+        size_t left = build(coordinates, keys, begin, middle, index);
+        size_t right = build(coordinates, keys, middle, end, index);
+        nodes[index].left = left;
+        nodes[index].right = right;
+        return index;
+    }
+
+    // Keeps the bounds above t valid after its key grew to key
+    void raise(size_t t, int key) {
+        for (size_t index = leaf[t]; nodes[index].max_key < key; index = nodes[index].parent) {
+            nodes[index].max_key = key;
+            if (index == 0) break;
+        }
+    }
+
+    // Calls improve(t, dist) for every terminal t with dist(t, box(u, w)) < keys[t], which may lower keys[t].
+    // Returns the new bound of the node
+    template <class Improve>
+    int lower_keys(size_t index, const std::vector<Coordinate>& coordinates, const std::vector<int>& keys,
+        const Coordinate& u, const Coordinate& w, Improve&& improve) {
+        Node& node = nodes[index];
+        long dx = std::max({0L, static_cast<long>(std::min(u.first, w.first)) - node.max_x,
+            static_cast<long>(node.min_x) - std::max(u.first, w.first)});
+        long dy = std::max({0L, static_cast<long>(std::min(u.second, w.second)) - node.max_y,
+            static_cast<long>(node.min_y) - std::max(u.second, w.second)});
+        if (dx + dy >= node.max_key) return node.max_key;
+
+        int max_key = -1;
+        if (node.left == 0) {
+            for (size_t i = node.begin; i < node.end; ++i) {
+                size_t t = order[i];
+                if (keys[t] < 0) continue; // already in the tree
+                int dist = distance_to_box(coordinates[t], u, w);
+                if (dist < keys[t]) improve(t, dist);
+                max_key = std::max(max_key, keys[t]);
+            }
+        } else {
+            max_key = std::max(lower_keys(node.left, coordinates, keys, u, w, improve),
+                lower_keys(node.right, coordinates, keys, u, w, improve));
+        }
+        nodes[index].max_key = max_key;
+        return max_key;
+    }
+};
+
+// Below this many terminals the plain scan of steiner_approx_slow is faster than the index
+const size_t STEINER_INDEX_MIN_SIZE = 16;
+
+// Binary heap of terminals ordered by (key, index) that can change the key of a terminal in it
+struct TerminalHeap {
+    const std::vector<int>& keys;
+    std::vector<size_t> heap;
+    std::vector<size_t> position; // in heap, size() if not in it
+
+    TerminalHeap(const std::vector<int>& keys) : keys(keys), position(keys.size(), keys.size()) {}
+
+    bool empty() const { return heap.empty(); }
+    size_t top() const { return heap[0]; }
+    bool before(size_t a, size_t b) const { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); }
+
+    // Adds t or moves it after its key changed
+    void update(size_t t) {
+        if (position[t] == keys.size()) {
+            position[t] = heap.size();
+            heap.push_back(t);
+        }
+        up(position[t]);
+        down(position[t]);
+    }
+    void pop() {
+        size_t t = heap[0];
+        heap[0] = heap.back();
+        position[heap[0]] = 0;
+        heap.pop_back();
+        position[t] = keys.size();
+        if (!heap.empty()) down(0);
+    }
+
+private:
+    void place(size_t i, size_t t) {
+        heap[i] = t;
+        position[t] = i;
+    }
+    void up(size_t i) {
+        size_t t = heap[i];
+        while (i > 0 && before(t, heap[(i - 1) / 2])) {
+            place(i, heap[(i - 1) / 2]);
+            i = (i - 1) / 2;
+        }
+        place(i, t);
+    }
+    void down(size_t i) {
+        size_t t = heap[i];
+        while (2 * i + 1 < heap.size()) {
+            size_t child = 2 * i + 1;
+            if (child + 1 < heap.size() && before(heap[child + 1], heap[child])) ++child;
+            if (!before(heap[child], t)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, t);
+    }
+};
+
+// Computes the same approximate Steiner tree as steiner_approx_slow in about O(n log n) time for spread out
+// terminals. The slow version inserts the terminal s closest to an edge e of the tree (ties broken by the
+// order of the terminals, then by the age of the edges) and replaces e by three edges through the closest
+// point v of its box. Here every terminal t has a key, a lower bound of its distance to the tree, and the
+// closest edge best[t] (ties to the older edge), with key[t] its exact distance while best[t] is in the tree.
+// The terminals are taken from a heap by key; one whose best edge was replaced gets the closest edge again
+// from the edge grid and goes back into the heap. Of the new edges (u,v) and (v,w) lie in the box of the
+// replaced edge, so they are never closer to a terminal than the tree already was, only (s,v) can lower keys
+int steiner_approx(const std::vector<Coordinate>& coordinates) {
+    if (coordinates.size() < STEINER_INDEX_MIN_SIZE) return steiner_approx_slow(coordinates);
+
+    size_t size = coordinates.size();
+    std::vector<Coordinate> edge_u;
+    std::vector<Coordinate> edge_w;
+    std::vector<bool> in_tree;   // false once an edge is replaced
+    EdgeGrid grid(coordinates);
+    auto add_edge = [&](const Coordinate& u, const Coordinate& w) {
+        size_t edge = edge_u.size();
+        edge_u.push_back(u);
+        edge_w.push_back(w);
+        in_tree.push_back(true);
+        grid.insert(edge, u, w);
+        return edge;
+    };
+    add_edge(coordinates[0], coordinates[1]);
+
+    std::vector<int> keys(size, -1); // -1 for the terminals in the tree
+    std::vector<size_t> best(size, 0);
+    std::vector<size_t> terminals;
+    TerminalHeap heap(keys);
+    for (size_t t = 2; t < size; ++t) {
+        keys[t] = distance_to_box(coordinates[t], edge_u[0], edge_w[0]);
+        terminals.push_back(t);
+        heap.update(t);
+    }
+    TerminalTree tree(coordinates, terminals, keys);
+
+    // Closest edge of the tree to c, searching the grid in rings of cells around c until no closer one can follow
+    auto closest_edge = [&](const Coordinate& c, size_t& closest) {
+        int min_dist = std::numeric_limits<int>::max();
+        int cx = grid.column(c.first);
+        int cy = grid.row(c.second);
+        int max_ring = std::max({cx, grid.columns - 1 - cx, cy, grid.rows - 1 - cy});
+        long cell_side = std::min(grid.cell_width, grid.cell_height);
+        for (int ring = 0; ring <= max_ring; ++ring) {
+            if (ring > 0 && (ring - 1) * cell_side > min_dist) break;
+            for (int r = std::max(0, cy - ring); r <= std::min(grid.rows - 1, cy + ring); ++r) {
+                bool full_row = r == cy - ring || r == cy + ring;
+                int step = full_row ? 1 : 2 * ring;
+                for (int col = cx - ring; col <= cx + ring; col += std::max(step, 1)) {
+                    if (col < 0 || col >= grid.columns) continue;
+                    auto& cell = grid.cells[static_cast<size_t>(r) * grid.columns + col];
+                    cell.erase(std::remove_if(cell.begin(), cell.end(), [&](size_t e) { return !in_tree[e]; }), cell.end());
+                    for (size_t e : cell) {
+                        int dist = distance_to_box(c, edge_u[e], edge_w[e]);
+                        if (dist < min_dist || (dist == min_dist && e < closest)) {
+                            min_dist = dist;
+                            closest = e;
+                        }
+                    }
+                }
+            }
+        }
+        return min_dist;
+    };
+
+    while (!heap.empty()) {
+        size_t s_index = heap.top();
+        const Coordinate& s = coordinates[s_index];
+        if (!in_tree[best[s_index]]) {
+            keys[s_index] = closest_edge(s, best[s_index]);
+            tree.raise(s_index, keys[s_index]);
+            heap.update(s_index);
+            continue;
+        }
+        // No other terminal can be closer, or as close with a smaller index, since their keys are lower bounds
+        heap.pop();
+        keys[s_index] = -1;
+
+        size_t replaced = best[s_index];
+        in_tree[replaced] = false;
+        Coordinate u = edge_u[replaced];
+        Coordinate w = edge_w[replaced];
+
+        // The vertex v on the shortest path area from u to w that is closest to s
+        Coordinate v;
+        v.first = std::min(std::max(s.first, std::min(u.first, w.first)), std::max(u.first, w.first));
+        v.second = std::min(std::max(s.second, std::min(u.second, w.second)), std::max(u.second, w.second));
+
+        add_edge(u, v);
+        add_edge(w, v);
+        if (s.first != v.first || s.second != v.second) {
+            size_t edge = add_edge(s, v);
+            tree.lower_keys(0, coordinates, keys, s, v, [&](size_t t, int dist) {
+                keys[t] = dist;
+                best[t] = edge;
+                heap.update(t);
+            });
+        }
+    }
+
+    int total_distance = 0;
+    for (size_t e = 0; e < edge_u.size(); ++e) {
+        if (in_tree[e]) total_distance += std::abs(edge_u[e].first - edge_w[e].first) + std::abs(edge_u[e].second - edge_w[e].second);
+    }
+    return total_distance;
+}
+
+
+// Computes an approximate Steiner tree length by edge substitution (Borah, Owens and Irwin). Starting from a
+// minimum spanning tree, a point p is connected to a nearby tree edge e at the point s of the box of e closest
+// to p (e is split at s, which does not change its length), and the longest edge on the tree path from p to e
+// is removed from the cycle that closes; the gain is its length minus dist(p, s). Every round collects the
+// pairs of a point p and an edge at one of its neighbours (octant neighbours from the MST sweep, and tree
+// neighbours), sorts them by gain and applies them in that order as long as their paths do not cross an edge
+// that was already removed or split in the round. Later rounds only look at the points around the changes of
+// the previous one; most of the gain comes in the first two, so the rounds stop when one gains less than 2%.
+// Each round takes O(n log n) time
+int steiner_boi(const std::vector<Coordinate>& coordinates) {
+    if (coordinates.size() < 3) return mst_length(coordinates);
+
+    const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    const int WALK_LIMIT = 64; // longer paths are followed with binary lifting
+    const long ROUND_MIN_GAIN = 50; // stop after a round that shortened the tree by less than 1/50
+    size_t terminal_count = coordinates.size();
+
+    // Octant neighbours of the terminals, the Steiner points only use their tree neighbours
+    std::vector<WeightedEdge> octant = octant_edges(coordinates);
+    std::vector<size_t> octant_first(terminal_count + 1, 0);
+    std::vector<size_t> octant_neighbours(2 * octant.size());
+    for (const auto& edge : octant) {
+        ++octant_first[std::get<1>(edge) + 1];
+        ++octant_first[std::get<2>(edge) + 1];
+    }
+    for (size_t v = 0; v < terminal_count; ++v) octant_first[v + 1] += octant_first[v];
+    {
+        std::vector<size_t> next(octant_first.begin(), octant_first.end() - 1);
+        for (const auto& [length, i, j] : octant) {
+            octant_neighbours[next[i]++] = j;
+            octant_neighbours[next[j]++] = i;
+        }
+    }
+
+    std::vector<Coordinate> points(coordinates); // the terminals first, then the Steiner points
+    std::vector<std::pair<size_t, size_t>> edges;
+    for (const auto& edge : kruskal(terminal_count, std::move(octant))) edges.emplace_back(std::get<1>(edge), std::get<2>(edge));
+    std::vector<bool> touched(points.size(), true); // points next to a change of the previous round
+
+    struct Substitution {
+        long gain;
+        size_t p;
+        size_t e; // the edge p is connected to
+        size_t x; // the end of e that the path from p reaches first
+        size_t removed; // the longest edge on that path
+    };
+
+    long total_length = std::numeric_limits<long>::max();
+    while (true) {
+        size_t size = points.size();
+        std::vector<long> lengths(edges.size());
+        for (size_t e = 0; e < edges.size(); ++e) {
+            const Coordinate& a = points[edges[e].first];
+            const Coordinate& b = points[edges[e].second];
+            lengths[e] = std::abs(static_cast<long>(a.first) - b.first) + std::abs(static_cast<long>(a.second) - b.second);
+        }
+        long previous_length = total_length;
+        total_length = std::accumulate(lengths.begin(), lengths.end(), 0L);
+        if (previous_length - total_length < previous_length / ROUND_MIN_GAIN) break;
+
+        // Incident edges of every point
+        std::vector<size_t> first(size + 1, 0);
+        for (const auto& [a, b] : edges) {
+            ++first[a + 1];
+            ++first[b + 1];
+        }
+        for (size_t v = 0; v < size; ++v) first[v + 1] += first[v];
+        std::vector<size_t> incident(2 * edges.size());
+        {
+            std::vector<size_t> next(first.begin(), first.end() - 1);
+            for (size_t e = 0; e < edges.size(); ++e) {
+                incident[next[edges[e].first]++] = e;
+                incident[next[edges[e].second]++] = e;
+            }
+        }
+        auto other_end = [&](size_t e, size_t v) { return edges[e].first == v ? edges[e].second : edges[e].first; };
+
+        // Root the tree at point 0: parents, depths and preorder numbers with the end of every subtree
+        std::vector<uint32_t> parent(size, 0);
+        std::vector<uint32_t> parent_edge(size, NONE);
+        std::vector<size_t> depth(size, 0);
+        std::vector<size_t> preorder(size, 0);
+        std::vector<size_t> subtree_end(size, 0);
+        {
+            std::vector<std::pair<size_t, size_t>> stack{{0, first[0]}};
+            size_t counter = 0;
+            preorder[0] = counter++;
+            while (!stack.empty()) {
+                auto& [v, next] = stack.back();
+                if (next == first[v + 1]) {
+                    subtree_end[v] = counter;
+                    stack.pop_back();
+                    continue;
+                }
+                size_t e = incident[next++];
+                if (e == parent_edge[v]) continue;
+                size_t w = other_end(e, v);
+                parent[w] = static_cast<uint32_t>(v);
+                parent_edge[w] = static_cast<uint32_t>(e);
+                depth[w] = depth[v] + 1;
+                preorder[w] = counter++;
+                stack.emplace_back(w, first[w]);
+            }
+        }
+        auto longer = [&](uint32_t a, uint32_t b) {
+            if (a == NONE) return b;
+            if (b == NONE) return a;
+            return lengths[b] > lengths[a] ? b : a;
+        };
+
+        // Binary lifting (ancestor 2^k levels up and the longest edge on the way), built on first use
+        size_t levels = 1;
+        while ((size_t(1) << levels) < size) ++levels;
+        std::vector<uint32_t> up;
+        std::vector<uint32_t> longest;
+        auto lift = [&]() {
+            up.resize(size * levels);
+            longest.resize(size * levels);
+            for (size_t v = 0; v < size; ++v) {
+                up[v * levels] = parent[v];
+                longest[v * levels] = parent_edge[v];
+            }
+            // parents come before their children in preorder, so go through the points in that order
+            std::vector<size_t> by_preorder(size);
+            for (size_t v = 0; v < size; ++v) by_preorder[preorder[v]] = v;
+            for (size_t v : by_preorder) {
+                for (size_t k = 1; k < levels; ++k) {
+                    uint32_t middle = up[v * levels + k - 1];
+                    up[v * levels + k] = up[middle * levels + k - 1];
+                    longest[v * levels + k] = longer(longest[v * levels + k - 1], longest[middle * levels + k - 1]);
+                }
+            }
+        };
+
+        // Longest edge on the path from u to v and their lowest common ancestor. Neighbouring points are
+        // mostly close in the tree too, so the parents are followed first
+        auto path = [&](size_t u, size_t v, size_t& ancestor) {
+            uint32_t result = NONE;
+            for (int step = 0; step < WALK_LIMIT; ++step) {
+                if (u == v) {
+                    ancestor = u;
+                    return result;
+                }
+                if (depth[u] < depth[v]) std::swap(u, v);
+                result = longer(result, parent_edge[u]);
+                u = parent[u];
+            }
+            if (up.empty()) lift();
+            if (depth[u] < depth[v]) std::swap(u, v);
+            for (size_t k = levels; k-- > 0;) {
+                if (depth[u] - depth[v] >= (size_t(1) << k)) {
+                    result = longer(result, longest[u * levels + k]);
+                    u = up[u * levels + k];
+                }
+            }
+            if (u != v) {
+                for (size_t k = levels; k-- > 0;) {
+                    if (up[u * levels + k] != up[v * levels + k]) {
+                        result = longer(result, longer(longest[u * levels + k], longest[v * levels + k]));
+                        u = up[u * levels + k];
+                        v = up[v * levels + k];
+                    }
+                }
+                result = longer(result, longer(parent_edge[u], parent_edge[v]));
+                u = parent[u];
+            }
+            ancestor = u;
+            return result;
+        };
+
+        // Candidate substitutions: p with the edges at its neighbours, if p or a neighbour was touched. The
+        // stamps skip neighbours and edges that were already seen for p
+        std::vector<Substitution> candidates;
+        std::vector<size_t> neighbours;
+        std::vector<size_t> point_stamp(size, NONE);
+        std::vector<size_t> edge_stamp(edges.size(), NONE);
+        for (size_t p = 0; p < size; ++p) {
+            neighbours.clear();
+            point_stamp[p] = p;
+            auto add_neighbour = [&](size_t q) {
+                if (point_stamp[q] == p) return;
+                point_stamp[q] = p;
+                neighbours.push_back(q);
+            };
+            if (p < terminal_count) {
+                for (size_t k = octant_first[p]; k < octant_first[p + 1]; ++k) add_neighbour(octant_neighbours[k]);
+            }
+            for (size_t k = first[p]; k < first[p + 1]; ++k) {
+                edge_stamp[incident[k]] = p; // the edges at p itself are no candidates
+                add_neighbour(other_end(incident[k], p));
+            }
+            if (!touched[p] && std::none_of(neighbours.begin(), neighbours.end(), [&](size_t q) { return touched[q]; })) continue;
+
+            for (size_t q : neighbours) {
+                for (size_t k = first[q]; k < first[q + 1]; ++k) {
+                    size_t e = incident[k];
+                    if (edge_stamp[e] == p) continue;
+                    edge_stamp[e] = p;
+                    auto [a, b] = edges[e];
+                    long dist = distance_to_box(points[p], points[a], points[b]);
+                    size_t child = parent_edge[a] == e ? a : b;
+                    bool below = preorder[child] <= preorder[p] && preorder[p] < subtree_end[child];
+                    size_t x = below ? child : other_end(e, child);
+                    size_t ancestor;
+                    uint32_t removed = path(p, x, ancestor);
+                    if (lengths[removed] > dist) candidates.push_back(Substitution{lengths[removed] - dist, p, e, x, removed});
+                }
+            }
+        }
+        if (candidates.empty()) break;
+        std::sort(candidates.begin(), candidates.end(), [](const Substitution& a, const Substitution& b) {
+            return std::tie(b.gain, a.p, a.e) < std::tie(a.gain, b.p, b.e);
+        });
+
+        // Apply them in order of gain. The paths are those of the tree at the start of the round, so a
+        // substitution is only taken if its path and its edge are untouched; the marked edges on the path to
+        // the root are counted with a Fenwick tree over the preorder
+        std::vector<long> marks_tree(size + 1, 0);
+        auto add_mark = [&](size_t position, long value) {
+            for (++position; position <= size; position += position & (~position + 1)) marks_tree[position] += value;
+        };
+        auto marks_above = [&](size_t v) {
+            long count = 0;
+            for (size_t position = preorder[v] + 1; position > 0; position -= position & (~position + 1)) count += marks_tree[position];
+            return count;
+        };
+        std::vector<bool> marked(edges.size(), false);
+        auto mark = [&](size_t e) {
+            marked[e] = true;
+            size_t child = parent_edge[edges[e].first] == e ? edges[e].first : edges[e].second;
+            add_mark(preorder[child], 1);
+            if (subtree_end[child] < size) add_mark(subtree_end[child], -1);
+        };
+        std::vector<Substitution> applied;
+        for (const auto& candidate : candidates) {
+            if (marked[candidate.e] || marked[candidate.removed]) continue;
+            size_t ancestor;
+            path(candidate.p, candidate.x, ancestor);
+            if (marks_above(candidate.p) + marks_above(candidate.x) - 2 * marks_above(ancestor) != 0) continue;
+            mark(candidate.e);
+            mark(candidate.removed);
+            applied.push_back(candidate);
+        }
+
+        // The new tree: e = (a, b) becomes (a, s) and (s, b) with a new Steiner point s unless s is a, b or p
+        std::vector<std::pair<size_t, size_t>> next_edges;
+        for (size_t e = 0; e < edges.size(); ++e) {
+            if (!marked[e]) next_edges.push_back(edges[e]);
+        }
+        std::vector<size_t> changed;
+        for (const auto& substitution : applied) {
+            auto [a, b] = edges[substitution.e];
+            const Coordinate& p = points[substitution.p];
+            Coordinate s;
+            s.first = std::min(std::max(p.first, std::min(points[a].first, points[b].first)), std::max(points[a].first, points[b].first));
+            s.second = std::min(std::max(p.second, std::min(points[a].second, points[b].second)), std::max(points[a].second, points[b].second));
+            size_t k;
+            if (s == points[a]) k = a;
+            else if (s == points[b]) k = b;
+            else if (s == p) k = substitution.p;
+            else {
+                k = points.size();
+                points.push_back(s);
+            }
+            if (k == a || k == b) next_edges.emplace_back(a, b);
+            else {
+                next_edges.emplace_back(a, k);
+                next_edges.emplace_back(k, b);
+            }
+            if (k != substitution.p) next_edges.emplace_back(substitution.p, k);
+            changed.insert(changed.end(), {a, b, k, substitution.p, edges[substitution.removed].first, edges[substitution.removed].second});
+        }
+        edges.swap(next_edges);
+
+        // Steiner points that became leaves only add length, remove them and renumber the others
+        std::vector<size_t> degree(points.size(), 0);
+        std::vector<std::vector<size_t>> point_edges(points.size());
+        for (size_t e = 0; e < edges.size(); ++e) {
+            ++degree[edges[e].first];
+            ++degree[edges[e].second];
+            point_edges[edges[e].first].push_back(e);
+            point_edges[edges[e].second].push_back(e);
+        }
+        std::vector<bool> edge_kept(edges.size(), true);
+        std::vector<size_t> leaves;
+        for (size_t v = terminal_count; v < points.size(); ++v) {
+            if (degree[v] == 1) leaves.push_back(v);
+        }
+        while (!leaves.empty()) {
+            size_t v = leaves.back();
+            leaves.pop_back();
+            for (size_t e : point_edges[v]) {
+                if (!edge_kept[e]) continue;
+                edge_kept[e] = false;
+                size_t w = edges[e].first == v ? edges[e].second : edges[e].first;
+                --degree[v];
+                changed.push_back(w);
+                if (--degree[w] == 1 && w >= terminal_count) leaves.push_back(w);
+            }
+        }
+        std::vector<size_t> number(points.size(), NONE);
+        std::vector<Coordinate> kept_points;
+        for (size_t v = 0; v < points.size(); ++v) {
+            if (v < terminal_count || degree[v] > 0) {
+                number[v] = kept_points.size();
+                kept_points.push_back(points[v]);
+            }
+        }
+        next_edges.clear();
+        for (size_t e = 0; e < edges.size(); ++e) {
+            if (edge_kept[e]) next_edges.emplace_back(number[edges[e].first], number[edges[e].second]);
+        }
+        touched.assign(kept_points.size(), false);
+        for (size_t v : changed) {
+            if (number[v] != NONE) touched[number[v]] = true;
+        }
+        points.swap(kept_points);
+        edges.swap(next_edges);
+    }
+
+    return static_cast<int>(total_length);
+}
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_AVX2 1
+#endif
+
+// Inner loops of the estimators on separate x and y arrays, as a scalar version and an AVX2 version (8 ints
+// per instruction). The version is chosen once at runtime by the CPU features, both give the same results:
+// only integer minima, maxima and sums (modulo 2^32, like the int sums they replace) are computed.
+namespace Kernels {
+
+constexpr std::size_t ALIGNMENT = 32; // one AVX2 register
+
+// Allocator for arrays starting at a multiple of ALIGNMENT
+template <class T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        std::size_t bytes = (n * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        void* data = std::aligned_alloc(ALIGNMENT, bytes == 0 ? ALIGNMENT : bytes);
+        if (data == nullptr) throw std::bad_alloc();
+        return static_cast<T*>(data);
+    }
+    void deallocate(T* data, std::size_t) { std::free(data); }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<int, AlignedAllocator<int>> AlignedInts;
+
+// Smallest and largest value, size > 0
+void min_max_scalar(const int* values, std::size_t size, int& min, int& max) {
+    min = std::numeric_limits<int>::max();
+    max = std::numeric_limits<int>::min();
+    for (std::size_t i = 0; i < size; ++i) {
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+}
+
+// Sum of |values[i] - center|
+int abs_distance_sum_scalar(const int* values, std::size_t size, int center) {
+    unsigned total = 0;
+    for (std::size_t i = 0; i < size; ++i) total += static_cast<unsigned>(std::abs(values[i] - center));
+    return static_cast<int>(total);
+}
+
+// One step of Prim: lowers weights[i] to the distance of (x[i], y[i]) to (px, py) and returns the first
+// index with the smallest weight, size > 0
+std::size_t prim_update_scalar(const int* x, const int* y, int* weights, std::size_t size, int px, int py) {
+    int min_weight = std::numeric_limits<int>::max();
+    std::size_t min_index = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        int distance = std::abs(x[i] - px) + std::abs(y[i] - py);
+        if (weights[i] > distance) weights[i] = distance;
+        if (weights[i] < min_weight || i == 0) {
+            min_weight = weights[i];
+            min_index = i;
+        }
+    }
+    return min_index;
+}
+
+#ifdef KERNELS_AVX2
+__attribute__((target("avx2")))
+void min_max_avx2(const int* values, std::size_t size, int& min, int& max) {
+    __m256i mins = _mm256_set1_epi32(std::numeric_limits<int>::max());
+    __m256i maxs = _mm256_set1_epi32(std::numeric_limits<int>::min());
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        mins = _mm256_min_epi32(mins, v);
+        maxs = _mm256_max_epi32(maxs, v);
+    }
+    alignas(ALIGNMENT) int lanes_min[8];
+    alignas(ALIGNMENT) int lanes_max[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes_min), mins);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes_max), maxs);
+    min = std::numeric_limits<int>::max();
+    max = std::numeric_limits<int>::min();
+    for (int lane = 0; lane < 8; ++lane) {
+        min = std::min(min, lanes_min[lane]);
+        max = std::max(max, lanes_max[lane]);
+    }
+    for (; i < size; ++i) {
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+}
+
+__attribute__((target("avx2")))
+int abs_distance_sum_avx2(const int* values, std::size_t size, int center) {
+    __m256i centers = _mm256_set1_epi32(center);
+    __m256i sums = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        sums = _mm256_add_epi32(sums, _mm256_abs_epi32(_mm256_sub_epi32(v, centers)));
+    }
+    alignas(ALIGNMENT) unsigned lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    unsigned total = 0;
+    for (int lane = 0; lane < 8; ++lane) total += lanes[lane];
+    for (; i < size; ++i) total += static_cast<unsigned>(std::abs(values[i] - center));
+    return static_cast<int>(total);
+}
+
+// Every lane keeps its smallest weight and the first index of it, then the lanes are compared
+__attribute__((target("avx2")))
+std::size_t prim_update_avx2(const int* x, const int* y, int* weights, std::size_t size, int px, int py) {
+    __m256i pxs = _mm256_set1_epi32(px);
+    __m256i pys = _mm256_set1_epi32(py);
+    __m256i min_weights = _mm256_set1_epi32(std::numeric_limits<int>::max());
+    __m256i min_indices = _mm256_setzero_si256();
+    __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i step = _mm256_set1_epi32(8);
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i xs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i ys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+        __m256i distances = _mm256_add_epi32(_mm256_abs_epi32(_mm256_sub_epi32(xs, pxs)), _mm256_abs_epi32(_mm256_sub_epi32(ys, pys)));
+        __m256i w = _mm256_min_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)), distances);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(weights + i), w);
+        __m256i smaller = _mm256_cmpgt_epi32(min_weights, w);
+        min_weights = _mm256_min_epi32(min_weights, w);
+        min_indices = _mm256_blendv_epi8(min_indices, indices, smaller);
+        indices = _mm256_add_epi32(indices, step);
+    }
+    alignas(ALIGNMENT) int lane_weights[8];
+    alignas(ALIGNMENT) int lane_indices[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_weights), min_weights);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_indices), min_indices);
+    int min_weight = std::numeric_limits<int>::max();
+    std::size_t min_index = 0;
+    bool found = false;
+    if (i > 0) {
+        for (int lane = 0; lane < 8; ++lane) {
+            std::size_t index = static_cast<std::size_t>(lane_indices[lane]);
+            if (!found || lane_weights[lane] < min_weight || (lane_weights[lane] == min_weight && index < min_index)) {
+                min_weight = lane_weights[lane];
+                min_index = index;
+                found = true;
+            }
+        }
+    }
+    for (; i < size; ++i) {
+        int distance = std::abs(x[i] - px) + std::abs(y[i] - py);
+        if (weights[i] > distance) weights[i] = distance;
+        if (weights[i] < min_weight || !found) {
+            min_weight = weights[i];
+            min_index = i;
+            found = true;
+        }
+    }
+    return min_index;
+}
+#endif
+
+struct Functions {
+    void (*min_max)(const int*, std::size_t, int&, int&);
+    int (*abs_distance_sum)(const int*, std::size_t, int);
+    std::size_t (*prim_update)(const int*, const int*, int*, std::size_t, int, int);
+};
+
+const Functions SCALAR = {min_max_scalar, abs_distance_sum_scalar, prim_update_scalar};
+#ifdef KERNELS_AVX2
+const Functions AVX2 = {min_max_avx2, abs_distance_sum_avx2, prim_update_avx2};
+#endif
+
+// Runs before main, so the CPU features have to be read first
+const Functions* select_functions() {
+#ifdef KERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return &AVX2;
+#endif
+    return &SCALAR;
+}
+
+// The kernels in use, AVX2 if the CPU has it unless use_scalar was called
+const Functions* current = select_functions();
+
+const Functions& functions() {
+    return *current;
+}
+
+bool uses_avx2() {
+#ifdef KERNELS_AVX2
+    return current == &AVX2;
+#else
+    return false;
+#endif
+}
+
+// For comparison, call before any threads are started
+void use_scalar() {
+    current = &SCALAR;
+}
+
+void min_max(const int* values, std::size_t size, int& min, int& max) {
+    functions().min_max(values, size, min, max);
+}
+
+int abs_distance_sum(const int* values, std::size_t size, int center) {
+    return functions().abs_distance_sum(values, size, center);
+}
+
+std::size_t prim_update(const int* x, const int* y, int* weights, std::size_t size, int px, int py) {
+    return functions().prim_update(x, y, weights, size, px, py);
+}
+
+}
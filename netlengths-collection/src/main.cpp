@@ -1,9 +1,16 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include "common.h"
+#include "kernels.cpp"
 #include "algorithms.cpp"
+#include "netlist.cpp"
+// instance reader shared with dijkstra-steiner
+#include "../../dijstra-steiner/src/mapped_file.cpp"
+#include "../../dijstra-steiner/src/instance_reader.cpp"
+#include "../../dijstra-steiner/src/server.cpp"
 // only for testing purposes
 #include <chrono>
 
@@ -17,14 +24,17 @@ void timing(const std::vector<Coordinate>& coordinates,
         "Star",
         "MST (lists and deletion)",
         "MST alt (vectors)",
-        "Steiner Approximation"
+        "Steiner Approximation",
+        "MST O(n log n) (octant sweep)",
+        "Steiner Approximation O(n^3) (scan)",
+        "Steiner edge substitution (BOI)"
     };
 
     auto start = std::chrono::high_resolution_clock::now();
     for(int i = 0; i < iterations; ++i) {
         switch (algorithm) {
         case 0: // Bounding Box
-            boundingBox(coordinates);
+            boundingBox(x_coordinates, y_coordinates);
             break;
         case 1: // Clique
             clique(x_coordinates, y_coordinates);
@@ -44,6 +54,15 @@ void timing(const std::vector<Coordinate>& coordinates,
         case 6: // Steiner Approximation
             steiner_approx(coordinates);
             break;
+        case 7: // MST sweep
+            mst_sweep(coordinates);
+            break;
+        case 8: // Steiner Approximation without the index
+            steiner_approx_slow(coordinates);
+            break;
+        case 9: // Steiner edge substitution
+            steiner_boi(coordinates);
+            break;
         default:
             std::cerr << "Unknown algorithm" << std::endl;
             return;
@@ -54,6 +73,43 @@ void timing(const std::vector<Coordinate>& coordinates,
     std::cout << "Elapsed time for algorithm " << algorithm_names[algorithm] << ": " << elapsed.count() << " seconds" << std::endl;
 }
 
+// Bits of the "what" field of a server request, 0 asks for all lengths
+enum Lengths {
+    BOUNDING_BOX = 1,
+    CLIQUE = 2,
+    STAR = 4,
+    MST = 8,
+    STEINER = 16,
+    STEINER_BOI = 32
+};
+
+// Buffers of a server thread, kept over its requests
+struct ServerBuffers {
+    std::vector<Coordinate> coordinates;
+    std::vector<int> x_coordinates;
+    std::vector<int> y_coordinates;
+    std::ostringstream out;
+};
+
+// Answer to a server request, the requested lengths one per line as printed for an input
+std::string answer(const Server::Request& request, ServerBuffers& buffers) {
+    unsigned what = request.what == 0 ? ~0u : request.what;
+    buffers.x_coordinates.assign(request.points.x.begin(), request.points.x.end());
+    buffers.y_coordinates.assign(request.points.y.begin(), request.points.y.end());
+    buffers.coordinates.clear();
+    for (std::size_t i = 0; i < request.points.size(); ++i) {
+        buffers.coordinates.emplace_back(request.points.x[i], request.points.y[i]);
+    }
+    buffers.out.str("");
+    if (what & BOUNDING_BOX) buffers.out << boundingBox(buffers.x_coordinates, buffers.y_coordinates) << '\n';
+    if (what & CLIQUE) buffers.out << clique(buffers.x_coordinates, buffers.y_coordinates) << '\n';
+    if (what & STAR) buffers.out << star(buffers.x_coordinates, buffers.y_coordinates) << '\n';
+    if (what & MST) buffers.out << mst_length(buffers.coordinates) << '\n';
+    if (what & STEINER) buffers.out << steiner_approx(buffers.coordinates) << '\n';
+    if (what & STEINER_BOI) buffers.out << steiner_boi(buffers.coordinates) << '\n';
+    return buffers.out.str();
+}
+
 int main(int argc, char* argv[]) {
     bool read_from_input = true; // Default value
     int size = 50; // Default number of coordinates
@@ -61,12 +117,32 @@ int main(int argc, char* argv[]) {
     bool timing_enabled = false; // Default value for timing
     int iterations; // Number of iterations for timing
     long seed = time(0); // Default seed for random number generation
+    std::string input_file; // Read from this file instead of stdin
+    bool server = false; // Answer length-prefixed requests on stdin
+    std::string socket_path; // Answer length-prefixed requests on this socket
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency()); // Server and netlist threads
+    bool netlist = false; // Read many nets, each with a header line
+    std::size_t chunk_pins = 1 << 20; // Pins read at once in netlist mode
 
     // Parse command-line arguments
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--no_input") {
             read_from_input = false;
+        } else if (arg == "--input" && i + 1 < argc) {
+            input_file = argv[++i];
+        } else if (arg == "--server") {
+            server = true;
+        } else if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--netlist") {
+            netlist = true;
+        } else if (arg == "--chunk" && i + 1 < argc) {
+            chunk_pins = std::max(1L, std::stol(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--scalar") {
+            Kernels::use_scalar();
         } else if (arg == "--size" && i + 1 < argc) {
             size = std::stoi(argv[++i]);
         } else if (arg == "--range" && i + 1 < argc) {
@@ -86,6 +162,13 @@ int main(int argc, char* argv[]) {
             std::cout << "Usage: " << argv[0] << " [options]\n"
                       << "Options:\n"
                       << "  --no_input       Generate coordinates instead of reading from input\n"
+                      << "  --input <file>   Read the coordinates from file instead of stdin (text or binary instance)\n"
+                      << "  --server         Answer length-prefixed requests on stdin until it is closed (see README)\n"
+                      << "  --socket <path>  Answer length-prefixed requests on a Unix domain socket at path\n"
+                      << "  --netlist        Read many nets, each as a line \"net <name> <degree>\" and its pins (see README)\n"
+                      << "  --chunk <n>      Netlist mode: number of pins read and measured at once (default: 1048576)\n"
+                      << "  --threads <n>    Number of nets or requests measured at the same time (default: one per core)\n"
+                      << "  --scalar         Use the scalar kernels even if the CPU supports AVX2\n"
                       << "  --size <n>       Number of coordinates to generate (default: 50)\n"
                       << "  --range <r>      Range for random coordinates (default: 50)\n"
                       << "  --seed <s>       Seed for random generation\n"
@@ -98,18 +181,53 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (server || !socket_path.empty()) {
+        std::vector<ServerBuffers> buffers(threads);
+        auto handler = [&buffers](const Server::Request& request, std::size_t thread) { return answer(request, buffers[thread]); };
+        try {
+            if (!socket_path.empty()) Server::serve_socket(socket_path, threads, handler);
+            else Server::serve(0, 1, threads, handler);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (netlist) {
+        std::FILE* in = input_file.empty() ? stdin : std::fopen(input_file.c_str(), "rb");
+        if (in == nullptr) {
+            std::cerr << "Cannot open file: " << input_file << std::endl;
+            return 1;
+        }
+        try {
+            Netlist::run(in, std::cout, threads, chunk_pins);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     std::vector<Coordinate> coordinates;
+    std::vector<int> x_coordinates;
+    std::vector<int> y_coordinates;
 
     if (read_from_input) {
-        std::string line;
-        while (std::getline(std::cin, line)) {
-            std::istringstream iss(line);
-            int x, y;
-            if (iss >> x >> y) {
-                coordinates.emplace_back(x, y);
-            } else {
-                std::cerr << "Invalid input: " << line << std::endl;
-            }
+        auto invalid = [](std::string_view line) { std::cerr << "Invalid input: " << line << std::endl; };
+        InstanceReader::Points points;
+        try {
+            points = input_file.empty()
+                ? InstanceReader::read_stdin(InstanceReader::Format::Lines, invalid)
+                : InstanceReader::read_file(input_file, InstanceReader::Format::Lines, invalid);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        x_coordinates = std::move(points.x);
+        y_coordinates = std::move(points.y);
+        for (std::size_t i = 0; i < x_coordinates.size(); ++i) {
+            coordinates.emplace_back(x_coordinates[i], y_coordinates[i]);
         }
     } else {
         unsigned s = (unsigned)(seed);
@@ -120,30 +238,29 @@ int main(int argc, char* argv[]) {
             // std::cout << "Generated coordinate: (" << x << ", " << y << ")" << std::endl;
             coordinates.emplace_back(x, y);
         }
+        for (auto &c : coordinates) {
+            x_coordinates.emplace_back(c.first);
+            y_coordinates.emplace_back(c.second);
+        }
     }
 
-    std::vector<int> x_coordinates;
-    std::vector<int> y_coordinates;
-
-    for (auto &c : coordinates) {
-        x_coordinates.emplace_back(c.first);
-        y_coordinates.emplace_back(c.second);
-    }
-
-    std::cout << boundingBox(coordinates) << std::endl;
+    std::cout << boundingBox(x_coordinates, y_coordinates) << std::endl;
 
     // std::cout << clique_slow(coordinates) << std::endl; // Slower for sufficiently large inputs
     std::cout << clique(x_coordinates, y_coordinates) << std::endl;
 
     std::cout << star(x_coordinates, y_coordinates) << std::endl;
 
-    std::cout << mst(coordinates) << std::endl;
+    std::cout << mst_length(coordinates) << std::endl; // Prim for small inputs, the octant sweep for large ones
     // std::cout << mst_alt(x_coordinates, y_coordinates) << std::endl; // Seems like it is always slower than mst
 
     std::cout << steiner_approx(coordinates) << std::endl;
 
+    std::cout << steiner_boi(coordinates) << std::endl; // Edge substitution, shorter than steiner_approx on larger nets
+
     // Timing analysis
     if(timing_enabled) {
+        std::cout << "Kernels: " << (Kernels::uses_avx2() ? "AVX2" : "scalar") << std::endl;
         timing(coordinates, x_coordinates, y_coordinates, 0, iterations); // Bounding Box
         timing(coordinates, x_coordinates, y_coordinates, 1, iterations); // Clique
         timing(coordinates, x_coordinates, y_coordinates, 2, iterations); // Clique Slow
@@ -151,6 +268,9 @@ int main(int argc, char* argv[]) {
         timing(coordinates, x_coordinates, y_coordinates, 4, iterations); // MST
         timing(coordinates, x_coordinates, y_coordinates, 5, iterations); // MST Alternative
         timing(coordinates, x_coordinates, y_coordinates, 6, iterations); // Steiner Approximation
+        timing(coordinates, x_coordinates, y_coordinates, 7, iterations); // MST sweep
+        timing(coordinates, x_coordinates, y_coordinates, 8, iterations); // Steiner Approximation Slow
+        timing(coordinates, x_coordinates, y_coordinates, 9, iterations); // Steiner edge substitution
     }
     return 0;
 }
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "common.h"
+
+// Netlist mode: many nets in one input, each a header line "net <name> <degree>" followed by <degree>
+// lines "x y". The input is read in blocks and the nets are collected into chunks of a bounded number
+// of pins, the nets of a chunk are measured on worker threads and printed in input order before the
+// next chunk is read. So the memory depends on the chunk size (or the largest net), not on the design.
+namespace Netlist {
+
+constexpr std::size_t READ_BLOCK_SIZE = std::size_t(1) << 20;
+
+struct Net {
+    std::string name;
+    std::vector<Coordinate> coordinates;
+    std::vector<int> x_coordinates;
+    std::vector<int> y_coordinates;
+};
+
+struct Lengths {
+    long bounding_box = 0;
+    double clique = 0;
+    long star = 0;
+    long mst = 0;
+    long steiner = 0;
+    long steiner_boi = 0;
+};
+
+// Nets with less than 2 pins have length 0 for every estimator
+Lengths measure(const Net& net) {
+    Lengths lengths;
+    if (net.coordinates.size() < 2) return lengths;
+    lengths.bounding_box = boundingBox(net.x_coordinates, net.y_coordinates);
+    lengths.clique = clique(net.x_coordinates, net.y_coordinates);
+    lengths.star = star(net.x_coordinates, net.y_coordinates);
+    lengths.mst = mst_length(net.coordinates);
+    lengths.steiner = steiner_approx(net.coordinates);
+    lengths.steiner_boi = steiner_boi(net.coordinates);
+    return lengths;
+}
+
+// Reads the nets one after the other, the buffer only holds the current block and an unfinished line
+class Reader {
+public:
+    explicit Reader(std::FILE* in) : _in(in) {}
+
+    // Fills net with the next one (reusing its vectors), false at the end of the input
+    bool next(Net& net) {
+        std::string_view line;
+        do {
+            if (!nextLine(line)) return false;
+        } while (blank(line));
+
+        const char* begin = line.data();
+        const char* end = line.data() + line.size();
+        std::string_view keyword = word(begin, end);
+        std::string_view name = word(begin, end);
+        std::size_t degree = 0;
+        skipBlanks(begin, end);
+        auto [last, error] = std::from_chars(begin, end, degree);
+        if (keyword != "net" || name.empty() || error != std::errc() || !blank(std::string_view(last, end - last))) {
+            fail("Expected \"net <name> <degree>\"");
+        }
+        net.name.assign(name);
+        net.coordinates.clear();
+        net.x_coordinates.clear();
+        net.y_coordinates.clear();
+
+        for (std::size_t i = 0; i < degree; ++i) {
+            if (!nextLine(line)) fail("Net " + net.name + " has less than " + std::to_string(degree) + " pins");
+            begin = line.data();
+            end = line.data() + line.size();
+            int x = 0;
+            int y = 0;
+            if (!number(begin, end, x) || !number(begin, end, y) || !blank(std::string_view(begin, end - begin))) {
+                fail("Expected \"x y\"");
+            }
+            net.coordinates.emplace_back(x, y);
+            net.x_coordinates.push_back(x);
+            net.y_coordinates.push_back(y);
+        }
+        return true;
+    }
+
+private:
+    bool nextLine(std::string_view& line) {
+        while (true) {
+            const char* first = _buffer.data() + _begin;
+            const char* newline = static_cast<const char*>(std::memchr(first, '\n', _buffer.size() - _begin));
+            if (newline != nullptr) {
+                line = std::string_view(first, newline - first);
+                _begin = newline + 1 - _buffer.data();
+                ++_line;
+                return true;
+            }
+            if (_ended) {
+                if (_begin == _buffer.size()) return false;
+                line = std::string_view(first, _buffer.size() - _begin);
+                _begin = _buffer.size();
+                ++_line;
+                return true;
+            }
+            // Keep the unfinished line and append the next block
+            _buffer.erase(0, _begin);
+            _begin = 0;
+            std::size_t size = _buffer.size();
+            _buffer.resize(size + READ_BLOCK_SIZE);
+            std::size_t read = std::fread(&_buffer[size], 1, READ_BLOCK_SIZE, _in);
+            _buffer.resize(size + read);
+            if (read < READ_BLOCK_SIZE) _ended = true;
+        }
+    }
+
+    static bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+    static void skipBlanks(const char*& begin, const char* end) {
+        while (begin != end && isBlank(*begin)) ++begin;
+    }
+    static bool blank(std::string_view line) {
+        return std::all_of(line.begin(), line.end(), isBlank);
+    }
+    static std::string_view word(const char*& begin, const char* end) {
+        skipBlanks(begin, end);
+        const char* first = begin;
+        while (begin != end && !isBlank(*begin)) ++begin;
+        return std::string_view(first, begin - first);
+    }
+    static bool number(const char*& begin, const char* end, int& value) {
+        skipBlanks(begin, end);
+        if (begin != end && *begin == '+') ++begin;
+        auto [last, error] = std::from_chars(begin, end, value);
+        begin = last;
+        return error == std::errc();
+    }
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error("Invalid netlist in line " + std::to_string(_line) + ": " + message);
+    }
+
+    std::FILE* _in;
+    std::string _buffer;
+    std::size_t _begin = 0;
+    bool _ended = false;
+    std::size_t _line = 0;
+};
+
+// The clique length of a net as printed for a single net, the total with its fraction
+void print(std::string& out, const std::string& name, const Lengths& lengths, bool is_total = false) {
+    char clique[32];
+    std::snprintf(clique, sizeof(clique), is_total ? "%.2f" : "%g", lengths.clique);
+    out += name;
+    out += ' ' + std::to_string(lengths.bounding_box) + ' ' + clique + ' ' + std::to_string(lengths.star)
+        + ' ' + std::to_string(lengths.mst) + ' ' + std::to_string(lengths.steiner) + ' ' + std::to_string(lengths.steiner_boi) + '\n';
+}
+
+// Prints "<name> <bb> <clique> <star> <mst> <steiner> <steiner-boi>" for every net and then the sums as net "total"
+void run(std::FILE* in, std::ostream& out, unsigned threads, std::size_t chunk_pins) {
+    Reader reader(in);
+    std::vector<Net> nets;       // the chunk, the nets are reused for the next one
+    std::vector<Lengths> lengths;
+    Lengths total;
+    std::string text;
+    bool ended = false;
+    std::size_t carried = 0;     // index of a net read for the next chunk, 0 if there is none
+    while (!ended) {
+        // Collect nets until the chunk is full. A net that does not fit any more starts the next chunk,
+        // so a larger net gets a chunk of its own
+        std::size_t count = 0;
+        std::size_t pins = 0;
+        if (carried != 0) {
+            std::swap(nets[0], nets[carried]);
+            pins = std::max<std::size_t>(nets[0].coordinates.size(), 1);
+            count = 1;
+            carried = 0;
+        }
+        while (pins < chunk_pins) {
+            if (count == nets.size()) nets.emplace_back();
+            if (!reader.next(nets[count])) {
+                ended = true;
+                break;
+            }
+            std::size_t net_pins = std::max<std::size_t>(nets[count].coordinates.size(), 1);
+            if (count != 0 && pins + net_pins > chunk_pins) {
+                carried = count;
+                break;
+            }
+            pins += net_pins;
+            ++count;
+        }
+
+        lengths.assign(count, Lengths());
+        std::atomic<std::size_t> next(0);
+        auto work = [&]() {
+            for (std::size_t i = next++; i < count; i = next++) lengths[i] = measure(nets[i]);
+        };
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < std::min<std::size_t>(threads, count); ++t) workers.emplace_back(work);
+        work();
+        for (auto& worker : workers) worker.join();
+
+        text.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            print(text, nets[i].name, lengths[i]);
+            total.bounding_box += lengths[i].bounding_box;
+            total.clique += lengths[i].clique;
+            total.star += lengths[i].star;
+            total.mst += lengths[i].mst;
+            total.steiner += lengths[i].steiner;
+            total.steiner_boi += lengths[i].steiner_boi;
+        }
+        out << text;
+    }
+    text.clear();
+    print(text, "total", total, true);
+    out << text << std::flush;
+}
+
+}